@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+
+Module:   Task Dispatch
+
+Purpose:  Runs the tasks of a partitioned job, in turn on the calling thread or, when
+          built with TASK_DISPATCH_PTHREADS, on one thread per task. Used by the
+          parallel template export and the parallel view build.
+
+Filename: task_dispatch.c
+
+------------------------------------------------------------------------------*/
+#include <template_api.h>
+#include <task_dispatch.h>
+#ifdef TASK_DISPATCH_PTHREADS
+#include <pthread.h>
+#endif
+
+/*------------------------------------------------------------------------------
+Module:   SerialTaskDispatch method
+
+Purpose:  Dispatcher running the tasks one after the other on the calling thread.
+
+Inputs:   task - Task to run
+          taskContexts, numTasks - One context per run
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS SerialTaskDispatch(TASK_DISPATCH_TASK task, void ** taskContexts, UNSIGNED16 numTasks)
+{
+	UNSIGNED16 index;
+
+	for(index = 0; index < numTasks; index++)
+		task(taskContexts[index]);
+
+	return OK;
+}
+
+#ifdef TASK_DISPATCH_PTHREADS
+typedef struct
+{
+	TASK_DISPATCH_TASK task;
+	void * taskContext;
+} TASK_DISPATCH_THREAD;
+
+static void * pthreadTaskEntry(void * argument)
+{
+	TASK_DISPATCH_THREAD * thread = (TASK_DISPATCH_THREAD *)argument;
+
+	thread->task(thread->taskContext);
+	return NULL;
+}
+
+/*------------------------------------------------------------------------------
+Module:   PthreadTaskDispatch method
+
+Purpose:  Dispatcher running the first task on the calling thread and every other
+          task on its own thread; a task whose thread cannot be created runs on the
+          calling thread.
+
+Inputs:   task - Task to run
+          taskContexts, numTasks - One context per run, at most
+                                   TASK_DISPATCH_MAX_WORKERS
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS PthreadTaskDispatch(TASK_DISPATCH_TASK task, void ** taskContexts, UNSIGNED16 numTasks)
+{
+	TASK_DISPATCH_THREAD threads[TASK_DISPATCH_MAX_WORKERS];
+	pthread_t threadIds[TASK_DISPATCH_MAX_WORKERS];
+	UNSIGNED8 started[TASK_DISPATCH_MAX_WORKERS] = {0};
+	UNSIGNED16 index;
+
+	if(numTasks > TASK_DISPATCH_MAX_WORKERS)
+		return ERROR_RESPONSE;
+
+	for(index = 1; index < numTasks; index++)
+	{
+		threads[index].task = task;
+		threads[index].taskContext = taskContexts[index];
+		started[index] = (pthread_create(&threadIds[index], NULL, pthreadTaskEntry, &threads[index]) == 0) ? TRUE : FALSE;
+	}
+
+	if(numTasks > 0)
+		task(taskContexts[0]);
+
+	for(index = 1; index < numTasks; index++)
+	{
+		if(started[index])
+			pthread_join(threadIds[index], NULL);
+		else
+			task(taskContexts[index]);
+	}
+
+	return OK;
+}
+#endif
@@ -0,0 +1,31 @@
+/***************************************************************************
+
+Description: This file holds the task dispatcher shared by the template and view
+             libraries to run partitioned work (parallel template export, parallel
+             view build).
+
+File Name: task_dispatch.h
+
+***************************************************************************/
+#ifndef TASKDISPATCH_H
+#define TASKDISPATCH_H
+
+//A dispatcher runs task once for every context and returns once all the runs have
+//completed. The caller cuts its work into at most TASK_DISPATCH_MAX_WORKERS
+//partitions, one context each, and merges the results in partition order so they do
+//not depend on the scheduling. With no dispatcher given, DefaultTaskDispatch runs the
+//tasks on pthreads when built with TASK_DISPATCH_PTHREADS, in turn otherwise.
+#define TASK_DISPATCH_MAX_WORKERS       16
+
+typedef void (*TASK_DISPATCH_TASK)(void * taskContext);
+typedef ERROR_STATUS (*TASK_DISPATCH)(TASK_DISPATCH_TASK task, void ** taskContexts, UNSIGNED16 numTasks);
+
+ERROR_STATUS SerialTaskDispatch(TASK_DISPATCH_TASK task, void ** taskContexts, UNSIGNED16 numTasks);
+#ifdef TASK_DISPATCH_PTHREADS
+ERROR_STATUS PthreadTaskDispatch(TASK_DISPATCH_TASK task, void ** taskContexts, UNSIGNED16 numTasks);
+#define DefaultTaskDispatch             PthreadTaskDispatch
+#else
+#define DefaultTaskDispatch             SerialTaskDispatch
+#endif
+
+#endif
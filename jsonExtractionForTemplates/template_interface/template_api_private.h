@@ -8,6 +8,7 @@ File Name: template_api_private.h
 ***************************************************************************/
 #ifndef TEMPLATEINTERFACE_PRIVATE_H
 #define TEMPLATEINTERFACE_PRIVATE_H
+#include <task_dispatch.h>
 
 
 ERROR_STATUS templateParse(APSHASHTBL * hashtbl, json_t * jsonTemplate, UNSIGNED16 templateKey);
@@ -15,6 +16,316 @@ ERROR_STATUS getTemplateInfo(UNSIGNED16 templateId, TEMPLATE_ENTRY ** templateIn
 ERROR_STATUS ReadTemplateFile(TCHAR * pTemplateName, SIGNED8 ** buffer,UNSIGNED8 tbool);
 ERROR_STATUS AddTemplateToHash(TCHAR * interfaceName, json_t * jsonTemplate, TEMPLATE_DATABASE * templateDb);
 ERROR_STATUS loadDataModelFile(TCHAR * jsonTemplatePath, SIGNED8 ** fileOutputBuffer);
+ERROR_STATUS GetTemplateFilePath(TCHAR * pTemplateName, TCHAR ** jsonFilePath, UNSIGNED8 tbool);
+ERROR_STATUS ReadTemplateFileFromPath(TCHAR * jsonFilePath, SIGNED8 ** buffer);
+
+//Warm start snapshot of the built template database. The snapshot is written next to
+//the template file (same name + TEMPLATE_SNAPSHOT_SUFFIX) and is only restored when the
+//CRC and size of the template file match the ones recorded in its header and the
+//payload matches its own CRC.
+#define TEMPLATE_SNAPSHOT_MAGIC       0x504E5354   //"TSNP"
+#define TEMPLATE_SNAPSHOT_VERSION     5
+#define TEMPLATE_SNAPSHOT_SUFFIX      _T(".snap")
+#define TEMPLATE_SNAPSHOT_ALIGN       8
+
+typedef struct
+{
+	UNSIGNED32 magic;
+	UNSIGNED16 snapshotVersion;
+	UNSIGNED16 coldInfoSize;       //sizeof(TEMPLATE_PROPERTY_COLD_INFO) of the build that wrote it
+	UNSIGNED32 sourceCrc;          //CRC-32 of the template file
+	UNSIGNED32 sourceSize;         //Size of the template file in bytes
+	UNSIGNED32 payloadSize;        //Bytes following this header
+	UNSIGNED32 payloadCrc;         //CRC-32 of the bytes following this header
+	UNSIGNED16 templateCount;      //TEMPLATE_DATABASE templateCount at the time of the dump
+	UNSIGNED16 entryCount;         //Number of template records in the payload
+} TEMPLATE_SNAPSHOT_HEADER;
+
+ERROR_STATUS GetTemplateFileCrc(TCHAR * jsonFilePath, UNSIGNED32 * crc, UNSIGNED32 * fileSize);
+ERROR_STATUS SaveTemplateSnapshot(TCHAR * jsonFilePath, UNSIGNED32 sourceCrc, UNSIGNED32 sourceSize, TEMPLATE_DATABASE * templateDb, TCHAR * templateVersion);
+ERROR_STATUS RestoreTemplateSnapshot(TCHAR * jsonFilePath, UNSIGNED32 sourceCrc, UNSIGNED32 sourceSize, TEMPLATE_DATABASE * templateDb, TCHAR ** templateVersion);
+
+typedef struct TEMPLATE_ENTRY_EXT_S TEMPLATE_ENTRY_EXT;
+
+//A property of a template: the template defining it and its index in the template's
+//property columns.
+typedef struct
+{
+	const TEMPLATE_ENTRY_EXT * owner;
+	UNSIGNED16 index;
+} TEMPLATE_PROPERTY_REF;
+
+//Effective (inheritance resolved) content of a template. Own properties and subcomponents
+//come first, followed by the inherited ones the template does not override. The entries
+//refer to the templates that define them and are read-only for the caller.
+//A template resolved again rebuilds its arrays in place as long as they are large
+//enough; only when an added ancestor makes them grow are they reallocated, so an
+//array pointer taken earlier is valid until the next template is added.
+typedef struct
+{
+	UNSIGNED16 parentTemplateId;                        //Resolved "-extends" template, 0 if none
+	UNSIGNED16 inheritanceDepth;                        //Number of ancestors
+	UNSIGNED16 numPropertyEntries;
+	TEMPLATE_PROPERTY_REF * propertyInfo;
+	UNSIGNED16 numSubComponentEntries;
+	TEMPLATE_SUBCOMPONENT_INFO ** subComponentInfo;
+} TEMPLATE_RESOLVED_INFO;
+
+//Resolution state of a template entry
+#define TEMPLATE_UNRESOLVED     0
+#define TEMPLATE_RESOLVING      1
+#define TEMPLATE_RESOLVED       2
+
+//Every template entry in templateStructureHash is allocated as TEMPLATE_ENTRY_EXT, the
+//TEMPLATE_ENTRY must stay the first member so the entry pointers can be cast to it.
+//The template's properties are held as structure of arrays sorted by attribute Id, all
+//indexed alike: the hot fields each in their own column (attribute Id column for the
+//binary search, data type column and TEMPLATE_PROPERTY_FLAG_xxx column for the filtered
+//scans) and the remaining fields in the cold array. The columns and the cold array share
+//one allocation. The TEMPLATE_PROPERTY_ATTR_INFO records handed out by the getters are
+//put together from them on first use (propertyList), along with the attribute hash of
+//the TEMPLATE_ENTRY. Subcomponents are held in one array in template file order
+//(subComponentList), the subcomponent hash points into it. GetTemplateKeyPropertyAttributes
+//and GetTemplateSubComponentList (and their const typed ...Ref forms) hand out these lists
+//themselves without allocating: they are owned by the template database, read-only for
+//the caller and never released by it.
+#define TEMPLATE_PROPERTY_FLAG_WRITABLE     0x01
+#define TEMPLATE_PROPERTY_FLAG_PRIORITY     0x02
+#define TEMPLATE_PROPERTY_FLAG_REQUIRED     0x04
+
+//Attribute membership filter of a template, consulted before the lookup so probing an
+//attribute the template does not have is a bit test. When the attribute Ids of the
+//template span at most TEMPLATE_MEMBERSHIP_BITSET_MAX_SPAN Ids the filter is an exact
+//bitset starting at the lowest Id; otherwise it is a blocked Bloom filter (two bits in
+//one 32 bit block per attribute) that may report false positives.
+#define TEMPLATE_MEMBERSHIP_BITSET_MAX_SPAN     512
+#define TEMPLATE_MEMBERSHIP_BLOOM_BITS_PER_ID   8
+#define TEMPLATE_MEMBERSHIP_HASH(attrId)        ((UNSIGNED32)(attrId) * 0x9E3779B1UL)
+#define TEMPLATE_MEMBERSHIP_BLOCK(hash, mask)   (((hash) >> 8) & (mask))
+#define TEMPLATE_MEMBERSHIP_BITS(hash)          ((1UL << ((hash) >> 27)) | (1UL << (((hash) >> 22) & 31)))
+
+typedef struct
+{
+	UNSIGNED16 base;                                    //Bitset: lowest attribute Id
+	UNSIGNED16 span;                                    //Bitset: number of bits, 0 for the Bloom filter
+	UNSIGNED16 blockMask;                               //Bloom filter: number of blocks - 1
+	UNSIGNED32 * bits;
+} TEMPLATE_MEMBERSHIP_FILTER;
+
+#ifdef USE_DOUBLE
+typedef FLOAT64 TEMPLATE_PROPERTY_REAL;
+#else
+typedef FLOAT32 TEMPLATE_PROPERTY_REAL;
+#endif
+
+//Cold fields of a property, everything but attrID, dataType, required, attrWritable
+//and attrPriority
+typedef struct
+{
+	TEMPLATE_PROPERTY_REAL min_IP;
+	TEMPLATE_PROPERTY_REAL max_IP;
+	TEMPLATE_PROPERTY_REAL min_SI;
+	TEMPLATE_PROPERTY_REAL max_SI;
+	UNSIGNED16 enumSet;
+	UNSIGNED16 redirectedEnumSetProp;
+	UNSIGNED16 dispPrec_IP;
+	UNSIGNED16 dispPrec_SI;
+	UNSIGNED16 attrNameset;
+	UNSIGNED16 attrName;
+	UNSIGNED16 attrDescriptionset;
+	UNSIGNED16 attrDescription;
+	UNSIGNED16 units_set;
+	UNSIGNED16 units_IP;
+	UNSIGNED16 units_SI;
+	UNSIGNED16 measurementType;
+	UNSIGNED16 redirectedUnits_IP_Prop;
+	UNSIGNED16 redirectedUnits_SI_Prop;
+	UNSIGNED16 redirectedMin_IP_Prop;
+	UNSIGNED16 redirectedMax_IP_Prop;
+	UNSIGNED16 redirectedMin_SI_Prop;
+	UNSIGNED16 redirectedMax_SI_Prop;
+	UNSIGNED8 redirectedVals;
+	UNSIGNED8 maxStringLength;
+} TEMPLATE_PROPERTY_COLD_INFO;
+
+struct TEMPLATE_ENTRY_EXT_S
+{
+	TEMPLATE_ENTRY entry;
+	UNSIGNED16 numProperties;
+	TEMPLATE_PROPERTY_COLD_INFO * propertyColdInfo;     //Start of the shared allocation
+	UNSIGNED16 * propertyAttrIds;
+	UNSIGNED8 * propertyDataTypes;
+	UNSIGNED8 * propertyFlags;
+	TEMPLATE_PROPERTY_ATTR_INFOLIST propertyList;       //Records, NULL until first asked for
+	TEMPLATE_MEMBERSHIP_FILTER membership;
+	TEMPLATE_SUBCOMPONENT_INFO_LIST subComponentList;
+	UNSIGNED8 resolveState;
+	TEMPLATE_RESOLVED_INFO resolvedInfo;
+	UNSIGNED16 maxResolvedProperties;                   //Room in resolvedInfo.propertyInfo
+	UNSIGNED16 maxResolvedSubComponents;                //Room in resolvedInfo.subComponentInfo
+	UNSIGNED32 addedGeneration;                         //Database generation the template was added in
+};
+
+ERROR_STATUS ResolveTemplateInheritance(TEMPLATE_DATABASE * templateDb);
+ERROR_STATUS ResolveAddedTemplate(TEMPLATE_DATABASE * templateDb, UNSIGNED16 templateId);
+ERROR_STATUS GetTemplateResolvedInfo(UNSIGNED16 templateId, TEMPLATE_RESOLVED_INFO ** resolvedInfo);
+ERROR_STATUS buildTemplatePropertyColumns(TEMPLATE_ENTRY_EXT * entryExt, const TEMPLATE_PROPERTY_ATTR_INFO * propertyArray);
+ERROR_STATUS buildTemplateMembershipFilter(TEMPLATE_ENTRY_EXT * entryExt);
+SIGNED32 findTemplatePropertyIndex(const TEMPLATE_ENTRY_EXT * entryExt, UNSIGNED16 attrId);
+void getTemplatePropertyRecord(const TEMPLATE_ENTRY_EXT * entryExt, UNSIGNED16 index, TEMPLATE_PROPERTY_ATTR_INFO * propertyInfo);
+ERROR_STATUS getTemplatePropertyRecords(TEMPLATE_ENTRY_EXT * entryExt);
+TEMPLATE_PROPERTY_ATTR_INFO * findTemplateProperty(TEMPLATE_ENTRY * templateInfo, UNSIGNED16 attrId);
+ERROR_STATUS TemplateHasProperty(UNSIGNED16 templateId, UNSIGNED16 attrId, UNSIGNED8 * hasProperty);
+ERROR_STATUS GetTemplatePropertiesByFlags(UNSIGNED16 templateId, UNSIGNED8 flagMask, UNSIGNED8 flagValue, UNSIGNED16 * attrIds, UNSIGNED16 maxAttrIds, UNSIGNED16 * numAttrIds);
+ERROR_STATUS GetTemplatePropertiesByDataType(UNSIGNED16 templateId, UNSIGNED8 dataType, UNSIGNED16 * attrIds, UNSIGNED16 maxAttrIds, UNSIGNED16 * numAttrIds);
+ERROR_STATUS GetTemplatePropertyArray(UNSIGNED16 templateId, TEMPLATE_PROPERTY_ATTR_INFO ** propertyArray, UNSIGNED16 * numProperties);
+ERROR_STATUS GetTemplatePropertyListRef(UNSIGNED16 templateId, const TEMPLATE_PROPERTY_ATTR_INFOLIST ** propertyList);
+ERROR_STATUS GetTemplateSubComponentListRef(UNSIGNED16 templateId, const TEMPLATE_SUBCOMPONENT_INFO_LIST ** subComponentList);
+
+//Handle on a template, obtained once from its template Id with GetTemplateHandle and
+//valid for the lifetime of the template database (entries are never moved or released).
+//Fields are read through the accessors below instead of one getter call per field.
+typedef const TEMPLATE_ENTRY_EXT * TEMPLATE_HANDLE;
+
+#define TEMPLATE_HANDLE_TYPE(handle)                    ((handle)->entry.type)
+#define TEMPLATE_HANDLE_SUBTYPE(handle)                 ((handle)->entry.subType)
+#define TEMPLATE_HANDLE_PRESENT_VALUE_ATTR_ID(handle)   ((handle)->entry.presentValueAttrId)
+#define TEMPLATE_HANDLE_NAME(handle)                    ((handle)->entry.templateName)
+#define TEMPLATE_HANDLE_DESCRIPTION(handle)             ((handle)->entry.templateDescription)
+#define TEMPLATE_HANDLE_PARENT(handle)                  ((handle)->entry.templateParent)
+#define TEMPLATE_HANDLE_DICTIONARY(handle)              ((handle)->entry.dictionaryName)
+#define TEMPLATE_HANDLE_ID(handle)                      ((handle)->entry.templateID)
+#define TEMPLATE_HANDLE_NUM_PROPERTIES(handle)          ((handle)->numProperties)
+#define TEMPLATE_HANDLE_SUBCOMPONENT_LIST(handle)       (&(handle)->subComponentList)
+#define TEMPLATE_HANDLE_PROPERTY(handle, attrId)        findTemplateProperty((TEMPLATE_ENTRY *)(handle), (attrId))
+
+ERROR_STATUS GetTemplateHandle(UNSIGNED16 templateId, TEMPLATE_HANDLE * templateHandle);
+
+//The template database is allocated as TEMPLATE_DATABASE_EXT, the TEMPLATE_DATABASE must
+//stay the first member so classVarPtr->template_database can be cast to it.
+typedef struct
+{
+	TEMPLATE_DATABASE database;
+	APSHASHTBL * instanceCacheHash;                     //Equipment object Id -> TEMPLATE_INSTANCE_CACHE
+	APSHASHTBL * propertyTemplatesHash;                 //Attribute Id -> TEMPLATE_POSTING_LIST
+	APSHASHTBL * subComponentParentsHash;               //Subcomponent template Id -> TEMPLATE_POSTING_LIST
+	APSHASHTBL * extendingTemplatesHash;                //"-extends" template ID -> TEMPLATE_POSTING_LIST
+	UNSIGNED32 generation;                              //Bumped whenever templates are added or dropped
+	struct TEMPLATE_EXPORT_S * exportCache;             //Last full export, holds one reference
+} TEMPLATE_DATABASE_EXT;
+
+//Reverse indexes of the template database: the templates declaring an attribute, the
+//templates embedding a subcomponent template and the templates extending a template.
+//Posting lists hold template Ids in the order the templates were added, kept current as
+//templates are added to the database.
+#define TEMPLATE_REVERSE_INDEX_GROW_SIZE            64
+#define TEMPLATE_POSTING_LIST_GROW_SIZE             8
+
+typedef struct
+{
+	UNSIGNED16 numTemplateIds;
+	UNSIGNED16 maxTemplateIds;
+	UNSIGNED16 * templateIds;
+} TEMPLATE_POSTING_LIST;
+
+ERROR_STATUS IndexTemplateReferences(TEMPLATE_DATABASE * templateDb, UNSIGNED16 templateId);
+ERROR_STATUS GetTemplatesByProperty(UNSIGNED16 attrId, const UNSIGNED16 ** templateIds, UNSIGNED16 * numTemplateIds);
+ERROR_STATUS GetTemplatesBySubComponentTemplate(TCHAR * subComponentTemplateId, const UNSIGNED16 ** templateIds, UNSIGNED16 * numTemplateIds);
+
+//Per equipment object copies of the properties with redirected values (units, enum set,
+//min/max read from the equipment object), keyed by TEMPLATE_INSTANCE_KEY. A copy is only
+//kept across calls once the object reported that it calls InvalidateTemplateInstanceCache
+//on changes (EnableTemplateInstanceCache) and all its values were read; otherwise it is
+//read again on every call, as without the cache.
+#define TEMPLATE_INSTANCE_DB_ENTRY_GROW_SIZE        16
+#define TEMPLATE_INSTANCE_PROPERTY_GROW_SIZE        16
+#define TEMPLATE_INSTANCE_KEY(templateId, attrId)   (((UNSIGNED32)(templateId) << 16) | (attrId))
+
+typedef struct
+{
+	TEMPLATE_PROPERTY_ATTR_INFO propertyInfo;           //Must be first, handed out to the caller
+	UNSIGNED8 valid;                                    //FALSE until kept, and once a source attribute changed
+} TEMPLATE_INSTANCE_PROPERTY;
+
+typedef struct
+{
+	OID_TYPE equipObjId;
+	UNSIGNED8 notified;                                 //TRUE once the object reports its changes
+	APSHASHTBL * propertyHash;
+} TEMPLATE_INSTANCE_CACHE;
+
+UNSIGNED8 readTemplateRedirectedValues(OID_TYPE equipObjId, TEMPLATE_PROPERTY_ATTR_INFO * attrInfo);
+ERROR_STATUS readTemplateRedirectedValuesList(OID_TYPE equipObjId, TEMPLATE_PROPERTY_ATTR_INFO ** attrInfos, UNSIGNED16 numAttrInfos, UNSIGNED8 * readComplete);
+ERROR_STATUS getTemplateInstancePropertyInfo(OID_TYPE equipObjId, UNSIGNED16 templateId, TEMPLATE_PROPERTY_ATTR_INFO * attrInfo, TEMPLATE_PROPERTY_ATTR_INFO ** instancePropertyInfo);
+ERROR_STATUS getTemplateInstancePropertyInfoList(OID_TYPE equipObjId, UNSIGNED16 templateId, TEMPLATE_PROPERTY_ATTR_INFO ** propertyInfos, UNSIGNED16 numPropertyInfos);
+ERROR_STATUS GetTemplatePropertyInfoList(UNSIGNED16 templateId, UNSIGNED16 * attrIds, UNSIGNED16 numAttrIds, OID_TYPE equipObjId, TEMPLATE_PROPERTY_ATTR_INFO ** templatePropertyInfos);
+ERROR_STATUS EnableTemplateInstanceCache(OID_TYPE equipObjId);
+ERROR_STATUS InvalidateTemplateInstanceCache(OID_TYPE equipObjId, UNSIGNED16 sourceAttrId);
+ERROR_STATUS ReleaseTemplateInstanceCache(OID_TYPE equipObjId);
+
+//Streaming JSON writer used by the template export. Without a sink the buffer grows and
+//holds the whole output, acquired with the jansson allocator so it can be handed out
+//(jsonWriterDetach); with a sink the buffer is a fixed staging area handed to the sink
+//whenever it fills, so the output is never held in memory as a whole.
+#define JSON_WRITER_BUFFER_SIZE     4096
+#define JSON_WRITER_MAX_DEPTH       8
+
+typedef struct JSON_WRITER_S JSON_WRITER;
+typedef ERROR_STATUS (*JSON_WRITER_SINK)(void * sinkContext, const UNSIGNED8 * data, UNSIGNED32 length);
+
+struct JSON_WRITER_S
+{
+	UNSIGNED8 * buffer;
+	UNSIGNED32 length;
+	UNSIGNED32 capacity;
+	JSON_WRITER_SINK sink;                              //NULL - buffer grows to hold the output
+	void * sinkContext;
+	UNSIGNED8 depth;
+	UNSIGNED8 needComma[JSON_WRITER_MAX_DEPTH];         //A value was written at this level
+	ERROR_STATUS status;                                //First error, later writes are no-ops
+	SIGNED8 * scratch;                                  //Reused to narrow Unicode strings
+	UNSIGNED32 scratchSize;
+};
+
+void jsonWriterInit(JSON_WRITER * writer, JSON_WRITER_SINK sink, void * sinkContext);
+void jsonWriterBeginObject(JSON_WRITER * writer, const SIGNED8 * key);
+void jsonWriterEndObject(JSON_WRITER * writer);
+void jsonWriterBeginArray(JSON_WRITER * writer, const SIGNED8 * key);
+void jsonWriterEndArray(JSON_WRITER * writer);
+void jsonWriterInteger(JSON_WRITER * writer, const SIGNED8 * key, SIGNED32 value);
+void jsonWriterReal(JSON_WRITER * writer, const SIGNED8 * key, FLOAT64 value);
+void jsonWriterString(JSON_WRITER * writer, const SIGNED8 * key, const SIGNED8 * value);
+void jsonWriterUnicodeString(JSON_WRITER * writer, const SIGNED8 * key, const TCHAR * value);
+ERROR_STATUS jsonWriterFinish(JSON_WRITER * writer);
+void jsonWriterRelease(JSON_WRITER * writer);
+SIGNED8 * jsonWriterDetach(JSON_WRITER * writer);
+ERROR_STATUS ExportTemplateDatabase(JSON_WRITER * writer, UNSIGNED32 sinceGeneration);
+ERROR_STATUS ExportTemplateFile(TCHAR * filePath);
+ERROR_STATUS ExportTemplateCompressedFile(TCHAR * filePath);
+//Parallel export: the templates are split in templateId order into up to
+//TASK_DISPATCH_MAX_WORKERS partitions, each serialized into its own buffer by a task
+//handed to the dispatcher (task_dispatch.h), and the fragments are joined in partition
+//order, giving the same document as CreateNewTemplate.
+ERROR_STATUS CreateNewTemplateParallel(UNSIGNED16 numWorkers, TASK_DISPATCH dispatch, char ** newTemplate);
+ERROR_STATUS MarkTemplateAdded(TEMPLATE_DATABASE * templateDb, UNSIGNED16 templateId);
+ERROR_STATUS GetTemplateGeneration(UNSIGNED32 * generation);
+
+//Full export of the template database handed out by GetTemplateExport. The database
+//keeps the latest one cached; each holder gives its reference back with
+//ReleaseTemplateExport and the document goes with the last reference, so a document
+//stays valid for its holder after the database moves on.
+typedef struct TEMPLATE_EXPORT_S
+{
+	UNSIGNED32 refCount;
+	UNSIGNED32 generation;                              //Database generation of the document
+	UNSIGNED32 length;                                  //Without the terminator
+	SIGNED8 * data;                                     //NUL terminated document, read-only
+} TEMPLATE_EXPORT;
+
+ERROR_STATUS GetTemplateExport(TEMPLATE_EXPORT ** templateExport);
+void ReleaseTemplateExport(TEMPLATE_EXPORT * templateExport);
+void ReleaseTemplateExportCache(TEMPLATE_DATABASE * templateDb);
+ERROR_STATUS CreateTemplateDelta(UNSIGNED32 sinceGeneration, char ** delta, UNSIGNED32 * generation);
 
 
 
@@ -0,0 +1,1508 @@
+/*------------------------------------------------------------------------------
+
+Module:   Template Export
+
+Purpose:  Serializes the template database back to the template JSON schema. The
+          output is produced by a streaming JSON writer straight into a growable
+          buffer or, through a fixed staging buffer, into a file, instead of building
+          a jansson object tree and dumping it. Optional members are written only when
+          they carry a value.
+
+Filename: template_export.c
+
+Inputs:   Template database of the equipment class
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+#include <float.h>
+#include <stdio.h>
+#include <template_api.h>
+#include "template_api_private.h"
+#include <unit.h>
+#include <zlib.h>
+
+//.jz files are gzip streams (the format DecompressJZFile and GetUncompressedFileSize read)
+#define JZ_WINDOW_BITS              (MAX_WBITS + 16)
+#define JZ_MEMORY_LEVEL             8
+
+typedef struct
+{
+	z_stream stream;
+	void * pFile;
+	UNSIGNED8 output[JSON_WRITER_BUFFER_SIZE];
+} JZ_SINK;
+
+//One partition of a parallel export, serialized by one task: measured first, then
+//written into its slice of the output
+typedef struct
+{
+	TEMPLATE_HANDLE * templates;
+	UNSIGNED16 numTemplates;
+	UNSIGNED8 * slice;                  //NULL while measuring
+	UNSIGNED32 length;                  //Measured length of the partition's output
+	UNSIGNED32 written;
+	ERROR_STATUS status;
+} TEMPLATE_EXPORT_PARTITION;
+
+//Significant digits needed to read back the same REAL, and the largest finite REAL
+#ifdef USE_DOUBLE
+#define JSON_WRITER_REAL_PRECISION  17
+#define JSON_WRITER_REAL_MAX        DBL_MAX
+#else
+#define JSON_WRITER_REAL_PRECISION  9
+#define JSON_WRITER_REAL_MAX        FLT_MAX
+#endif
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterInit method
+
+Purpose:  Prepares a writer. The buffer is acquired on the first write, with the
+          jansson allocator so a collected output can be handed out as json_dumps
+          output would be.
+
+Inputs:   writer - Writer to prepare
+          sink - Receives the output as the staging buffer fills, NULL to collect
+                 the whole output in the buffer
+          sinkContext - Passed to the sink
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+void jsonWriterInit(JSON_WRITER * writer, JSON_WRITER_SINK sink, void * sinkContext)
+{
+	OSmemset(writer, 0, sizeof(JSON_WRITER));
+	writer->sink = sink;
+	writer->sinkContext = sinkContext;
+	writer->status = OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterFlush method
+
+Purpose:  Hands the staged output to the sink and empties the staging buffer.
+
+Inputs:   writer - Writer with a sink
+
+Outputs:  None, a sink failure is kept in writer->status
+------------------------------------------------------------------------------*/
+static void jsonWriterFlush(JSON_WRITER * writer)
+{
+	ERROR_STATUS status;
+
+	if(writer->length == 0 || writer->status != OK)
+		return;
+
+	status = writer->sink(writer->sinkContext, writer->buffer, writer->length);
+	if(status != OK)
+		writer->status = status;
+
+	writer->length = 0;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterReserve method
+
+Purpose:  Makes room for length more bytes: flushes to the sink, or doubles the
+          buffer when there is no sink.
+
+Inputs:   writer - Writer
+          length - Bytes about to be written, at most JSON_WRITER_BUFFER_SIZE with a sink
+
+Outputs:  TRUE if the bytes can be written
+------------------------------------------------------------------------------*/
+static UNSIGNED8 jsonWriterReserve(JSON_WRITER * writer, UNSIGNED32 length)
+{
+	json_malloc_t jsonMalloc;
+	json_free_t jsonFree;
+	UNSIGNED8 * buffer;
+	UNSIGNED32 capacity;
+
+	if(writer->status != OK)
+		return FALSE;
+
+	if(writer->length + length <= writer->capacity)
+		return TRUE;
+
+	if(writer->sink != NULL && writer->buffer != NULL)
+	{
+		jsonWriterFlush(writer);
+		return (writer->status == OK) ? TRUE : FALSE;
+	}
+
+	capacity = (writer->capacity != 0) ? writer->capacity : JSON_WRITER_BUFFER_SIZE;
+	while(capacity < writer->length + length)
+		capacity *= 2;
+
+	json_get_alloc_funcs(&jsonMalloc, &jsonFree);
+
+	buffer = (UNSIGNED8 *)jsonMalloc(capacity);
+	if(buffer == NULL)
+	{
+		writer->status = NOT_ENOUGH_MEMORY;
+		return FALSE;
+	}
+
+	if(writer->buffer != NULL)
+	{
+		OSmemcpy(buffer, writer->buffer, writer->length);
+		jsonFree(writer->buffer);
+	}
+
+	writer->buffer = buffer;
+	writer->capacity = capacity;
+
+	return TRUE;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterBytes method
+
+Purpose:  Appends raw bytes to the output, in staging buffer sized pieces.
+
+Inputs:   writer - Writer
+          data, length - Bytes to append
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void jsonWriterBytes(JSON_WRITER * writer, const void * data, UNSIGNED32 length)
+{
+	const UNSIGNED8 * source = (const UNSIGNED8 *)data;
+	UNSIGNED32 chunk;
+
+	while(length > 0)
+	{
+		chunk = (writer->sink != NULL && length > JSON_WRITER_BUFFER_SIZE) ? JSON_WRITER_BUFFER_SIZE : length;
+
+		if(!jsonWriterReserve(writer, chunk))
+			return;
+
+		OSmemcpy(writer->buffer + writer->length, source, chunk);
+		writer->length += chunk;
+		source += chunk;
+		length -= chunk;
+	}
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterByte method
+
+Purpose:  Appends one byte to the output.
+
+Inputs:   writer - Writer
+          value - Byte to append
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void jsonWriterByte(JSON_WRITER * writer, UNSIGNED8 value)
+{
+	if(jsonWriterReserve(writer, 1))
+		writer->buffer[writer->length++] = value;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterQuoted method
+
+Purpose:  Appends an ASCII string as a quoted JSON string, escaping quotes,
+          backslashes and control characters.
+
+Inputs:   writer - Writer
+          value - NUL terminated string
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void jsonWriterQuoted(JSON_WRITER * writer, const SIGNED8 * value)
+{
+	static const SIGNED8 hexDigits[] = "0123456789abcdef";
+	const UNSIGNED8 * text = (const UNSIGNED8 *)value;
+	const UNSIGNED8 * run;
+	SIGNED8 escape[6];
+
+	jsonWriterByte(writer, '"');
+
+	while(*text)
+	{
+		//Copy the run of characters needing no escape in one go
+		for(run = text; *text >= 0x20 && *text != '"' && *text != '\\'; text++)
+			;
+
+		if(text != run)
+			jsonWriterBytes(writer, run, (UNSIGNED32)(text - run));
+
+		if(*text == '\0')
+			break;
+
+		escape[0] = '\\';
+		switch(*text)
+		{
+			case '"':  escape[1] = '"';  jsonWriterBytes(writer, escape, 2); break;
+			case '\\': escape[1] = '\\'; jsonWriterBytes(writer, escape, 2); break;
+			case '\n': escape[1] = 'n';  jsonWriterBytes(writer, escape, 2); break;
+			case '\r': escape[1] = 'r';  jsonWriterBytes(writer, escape, 2); break;
+			case '\t': escape[1] = 't';  jsonWriterBytes(writer, escape, 2); break;
+			default:
+				escape[1] = 'u';
+				escape[2] = '0';
+				escape[3] = '0';
+				escape[4] = hexDigits[*text >> 4];
+				escape[5] = hexDigits[*text & 0x0F];
+				jsonWriterBytes(writer, escape, 6);
+				break;
+		}
+		text++;
+	}
+
+	jsonWriterByte(writer, '"');
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterValueStart method
+
+Purpose:  Writes what precedes a value: the separating comma if the current object
+          or array already has a member, and the key of an object member.
+
+Inputs:   writer - Writer
+          key - Member key, NULL for an array element or the root value
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void jsonWriterValueStart(JSON_WRITER * writer, const SIGNED8 * key)
+{
+	if(writer->needComma[writer->depth])
+		jsonWriterByte(writer, ',');
+
+	writer->needComma[writer->depth] = TRUE;
+
+	if(key != NULL)
+	{
+		jsonWriterQuoted(writer, key);
+		jsonWriterByte(writer, ':');
+	}
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterOpen / jsonWriterClose methods
+
+Purpose:  Open and close a nested object or array.
+
+Inputs:   writer - Writer
+          key - Member key, NULL for an array element or the root value
+          bracket - '{', '[' / '}', ']'
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void jsonWriterOpen(JSON_WRITER * writer, const SIGNED8 * key, UNSIGNED8 bracket)
+{
+	jsonWriterValueStart(writer, key);
+	jsonWriterByte(writer, bracket);
+
+	if(writer->depth + 1 >= JSON_WRITER_MAX_DEPTH)
+	{
+		writer->status = ERROR_RESPONSE;
+		return;
+	}
+
+	writer->needComma[++writer->depth] = FALSE;
+}
+
+static void jsonWriterClose(JSON_WRITER * writer, UNSIGNED8 bracket)
+{
+	if(writer->depth > 0)
+		writer->depth--;
+
+	jsonWriterByte(writer, bracket);
+}
+
+void jsonWriterBeginObject(JSON_WRITER * writer, const SIGNED8 * key)
+{
+	jsonWriterOpen(writer, key, '{');
+}
+
+void jsonWriterEndObject(JSON_WRITER * writer)
+{
+	jsonWriterClose(writer, '}');
+}
+
+void jsonWriterBeginArray(JSON_WRITER * writer, const SIGNED8 * key)
+{
+	jsonWriterOpen(writer, key, '[');
+}
+
+void jsonWriterEndArray(JSON_WRITER * writer)
+{
+	jsonWriterClose(writer, ']');
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterInteger method
+
+Purpose:  Writes an integer member or element.
+
+Inputs:   writer - Writer
+          key - Member key, NULL for an array element
+          value - Value to write
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+void jsonWriterInteger(JSON_WRITER * writer, const SIGNED8 * key, SIGNED32 value)
+{
+	SIGNED8 digits[12];
+	UNSIGNED32 magnitude;
+	UNSIGNED8 position = sizeof(digits);
+
+	jsonWriterValueStart(writer, key);
+
+	magnitude = (value < 0) ? (UNSIGNED32)0 - (UNSIGNED32)value : (UNSIGNED32)value;
+
+	do
+	{
+		digits[--position] = (SIGNED8)('0' + magnitude % 10);
+		magnitude /= 10;
+	} while(magnitude != 0);
+
+	if(value < 0)
+		digits[--position] = '-';
+
+	jsonWriterBytes(writer, &digits[position], sizeof(digits) - position);
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterReal method
+
+Purpose:  Writes a real member or element as jansson does: printf "%.*g" with enough
+          digits to read back the same REAL value, the decimal point of the locale
+          turned into '.', and ".0" added to a value written without fraction or
+          exponent so it reads back as a real. JSON has no infinity, an infinite
+          value is written as the largest finite REAL of its sign; NaN is rejected.
+
+Inputs:   writer - Writer
+          key - Member key, NULL for an array element
+          value - Value to write
+
+Outputs:  None, a NaN sets ERROR_RESPONSE in writer->status
+------------------------------------------------------------------------------*/
+void jsonWriterReal(JSON_WRITER * writer, const SIGNED8 * key, FLOAT64 value)
+{
+	SIGNED8 text[JSON_WRITER_REAL_PRECISION + 16];
+	SIGNED32 length;
+	SIGNED32 index;
+	UNSIGNED8 isReal = FALSE;
+
+	if(value != value)
+	{
+		writer->status = ERROR_RESPONSE;
+		return;
+	}
+
+	if(value > JSON_WRITER_REAL_MAX)
+		value = JSON_WRITER_REAL_MAX;
+	else if(value < -JSON_WRITER_REAL_MAX)
+		value = -JSON_WRITER_REAL_MAX;
+
+	length = snprintf((char *)text, sizeof(text) - 2, "%.*g", JSON_WRITER_REAL_PRECISION, value);
+	if(length < 0 || length >= (SIGNED32)sizeof(text) - 2)
+	{
+		writer->status = ERROR_RESPONSE;
+		return;
+	}
+
+	for(index = 0; index < length; index++)
+	{
+		if(text[index] == ',')
+			text[index] = '.';
+
+		if(text[index] == '.' || text[index] == 'e')
+			isReal = TRUE;
+	}
+
+	if(!isReal)
+	{
+		text[length++] = '.';
+		text[length++] = '0';
+	}
+
+	jsonWriterValueStart(writer, key);
+	jsonWriterBytes(writer, text, (UNSIGNED32)length);
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterString method
+
+Purpose:  Writes a string member or element.
+
+Inputs:   writer - Writer
+          key - Member key, NULL for an array element
+          value - ASCII string to write
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+void jsonWriterString(JSON_WRITER * writer, const SIGNED8 * key, const SIGNED8 * value)
+{
+	jsonWriterValueStart(writer, key);
+	jsonWriterQuoted(writer, value);
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterUnicodeString method
+
+Purpose:  Writes a Unicode (UTF-16) string member or element. The string is narrowed
+          to UTF-8 into the writer's scratch buffer, which is reused across calls, so
+          no copy is acquired per string.
+
+Inputs:   writer - Writer
+          key - Member key, NULL for an array element
+          value - Unicode string to write
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+void jsonWriterUnicodeString(JSON_WRITER * writer, const SIGNED8 * key, const TCHAR * value)
+{
+	UNSIGNED8 * target;
+	UNSIGNED32 length, needed, codePoint;
+
+	if(writer->status != OK)
+		return;
+
+	length = OSstrlen(value);
+
+	//Worst case 3 bytes per UTF-16 unit, plus the terminator
+	needed = length * 3 + 1;
+	if(needed > writer->scratchSize)
+	{
+		if(writer->scratch != NULL)
+			OSrelease(writer->scratch);
+
+		writer->scratchSize = (needed > JSON_WRITER_BUFFER_SIZE / 16) ? needed : JSON_WRITER_BUFFER_SIZE / 16;
+		writer->scratch = (SIGNED8 *)OSacquire(writer->scratchSize);
+		if(writer->scratch == NULL)
+		{
+			writer->scratchSize = 0;
+			writer->status = NOT_ENOUGH_MEMORY;
+			return;
+		}
+	}
+
+	target = (UNSIGNED8 *)writer->scratch;
+
+	for(; *value; value++)
+	{
+		codePoint = *value;
+
+		if(codePoint < 0x80)
+		{
+			*target++ = (UNSIGNED8)codePoint;
+			continue;
+		}
+
+		//Surrogate pair, an unpaired surrogate is written as is
+		if(codePoint >= 0xD800 && codePoint <= 0xDBFF && value[1] >= 0xDC00 && value[1] <= 0xDFFF)
+		{
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (value[1] - 0xDC00);
+			value++;
+
+			*target++ = (UNSIGNED8)(0xF0 | (codePoint >> 18));
+			*target++ = (UNSIGNED8)(0x80 | ((codePoint >> 12) & 0x3F));
+		}
+		else if(codePoint >= 0x800)
+		{
+			*target++ = (UNSIGNED8)(0xE0 | (codePoint >> 12));
+		}
+		else
+		{
+			*target++ = (UNSIGNED8)(0xC0 | (codePoint >> 6));
+			*target++ = (UNSIGNED8)(0x80 | (codePoint & 0x3F));
+			continue;
+		}
+
+		*target++ = (UNSIGNED8)(0x80 | ((codePoint >> 6) & 0x3F));
+		*target++ = (UNSIGNED8)(0x80 | (codePoint & 0x3F));
+	}
+	*target = '\0';
+
+	jsonWriterValueStart(writer, key);
+	jsonWriterQuoted(writer, writer->scratch);
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterFinish method
+
+Purpose:  Completes the output: flushes the rest to the sink, or NUL terminates the
+          buffer when there is no sink (the terminator is not counted in length).
+
+Inputs:   writer - Writer
+
+Outputs:  First error met while writing, OK otherwise
+------------------------------------------------------------------------------*/
+ERROR_STATUS jsonWriterFinish(JSON_WRITER * writer)
+{
+	if(writer->sink != NULL)
+	{
+		jsonWriterFlush(writer);
+	}
+	else if(jsonWriterReserve(writer, 1))
+	{
+		writer->buffer[writer->length] = '\0';
+	}
+
+	return writer->status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterRelease method
+
+Purpose:  Releases the buffers of the writer.
+
+Inputs:   writer - Writer
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+void jsonWriterRelease(JSON_WRITER * writer)
+{
+	json_malloc_t jsonMalloc;
+	json_free_t jsonFree;
+
+	if(writer->buffer != NULL)
+	{
+		json_get_alloc_funcs(&jsonMalloc, &jsonFree);
+		jsonFree(writer->buffer);
+	}
+
+	if(writer->scratch != NULL)
+		OSrelease(writer->scratch);
+
+	writer->buffer = NULL;
+	writer->length = 0;
+	writer->capacity = 0;
+	writer->scratch = NULL;
+	writer->scratchSize = 0;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jsonWriterDetach method
+
+Purpose:  Hands the collected output over to the caller and releases the rest of the
+          writer. Called after a successful jsonWriterFinish on a writer without sink.
+
+Inputs:   writer - Writer
+
+Outputs:  NUL terminated output, acquired with the jansson allocator; the caller
+          releases it with the jansson free function as json_dumps output
+------------------------------------------------------------------------------*/
+SIGNED8 * jsonWriterDetach(JSON_WRITER * writer)
+{
+	SIGNED8 * output = (SIGNED8 *)writer->buffer;
+
+	writer->buffer = NULL;
+	jsonWriterRelease(writer);
+
+	return output;
+}
+
+/*------------------------------------------------------------------------------
+Module:   writeUnicodeMember method
+
+Purpose:  Writes a Unicode string member.
+
+Inputs:   writer - Writer
+          key - Member key
+          value - Unicode string, nothing is written if NULL
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void writeUnicodeMember(JSON_WRITER * writer, const SIGNED8 * key, const TCHAR * value)
+{
+	if(value != NULL)
+		jsonWriterUnicodeString(writer, key, value);
+}
+
+/*------------------------------------------------------------------------------
+Module:   writeSetValueMember method
+
+Purpose:  Writes a {"-setId", "-value"} member.
+
+Inputs:   writer - Writer
+          key - Member key
+          setId, value - String set Id and value
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void writeSetValueMember(JSON_WRITER * writer, const SIGNED8 * key, UNSIGNED16 setId, UNSIGNED16 value)
+{
+	jsonWriterBeginObject(writer, key);
+	jsonWriterInteger(writer, "-setId", setId);
+	jsonWriterInteger(writer, "-value", value);
+	jsonWriterEndObject(writer);
+}
+
+/*------------------------------------------------------------------------------
+Module:   writeTemplateProperty method
+
+Purpose:  Writes one element of "-Property". Units, measurement type and ranges are
+          written when the template defined them, redirect properties when set.
+
+Inputs:   writer - Writer
+          propertyInfo - Property to write
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void writeTemplateProperty(JSON_WRITER * writer, const TEMPLATE_PROPERTY_ATTR_INFO * propertyInfo)
+{
+	jsonWriterBeginObject(writer, NULL);
+
+	if(propertyInfo->attrID >= 7000)
+		jsonWriterInteger(writer, "-ID", propertyInfo->attrID);
+
+	jsonWriterInteger(writer, "-Required", propertyInfo->required);
+	jsonWriterInteger(writer, "-DataType", propertyInfo->dataType);
+
+	if(propertyInfo->enumSet > 0)
+		jsonWriterInteger(writer, "-StringsetId", propertyInfo->enumSet);
+
+	if(propertyInfo->redirectedVals && propertyInfo->redirectedEnumSetProp)
+		jsonWriterInteger(writer, "-StringsetProperty", propertyInfo->redirectedEnumSetProp);
+
+	jsonWriterInteger(writer, "-WritableFlag", propertyInfo->attrWritable);
+	jsonWriterInteger(writer, "-PriorityFlag", propertyInfo->attrPriority);
+
+	if(propertyInfo->maxStringLength > 0)
+		jsonWriterInteger(writer, "-MaxStringLength", propertyInfo->maxStringLength);
+
+	if(propertyInfo->dispPrec_IP > 0)
+		jsonWriterInteger(writer, "-IPDisplayPrecision", propertyInfo->dispPrec_IP);
+
+	if(propertyInfo->dispPrec_SI > 0)
+		jsonWriterInteger(writer, "-SIDisplayPrecision", propertyInfo->dispPrec_SI);
+
+	writeSetValueMember(writer, "-Name", propertyInfo->attrNameset, propertyInfo->attrName);
+
+	if(propertyInfo->attrDescriptionset != 0 && propertyInfo->attrDescription != 0)
+		writeSetValueMember(writer, "-Description", propertyInfo->attrDescriptionset, propertyInfo->attrDescription);
+
+	//Units are 0 unless the template has the member, NO_UNITS if it has no "-value"
+	if(propertyInfo->units_IP != 0)
+	{
+		jsonWriterBeginObject(writer, "-IPUnits");
+		jsonWriterInteger(writer, "-setId", propertyInfo->units_set);
+		jsonWriterInteger(writer, "-value", propertyInfo->units_IP);
+		if(propertyInfo->redirectedVals && propertyInfo->redirectedUnits_IP_Prop)
+			jsonWriterInteger(writer, "-IPUnitsProperty", propertyInfo->redirectedUnits_IP_Prop);
+		jsonWriterEndObject(writer);
+	}
+
+	if(propertyInfo->units_SI != 0)
+	{
+		jsonWriterBeginObject(writer, "-SIUnits");
+		jsonWriterInteger(writer, "-setId", propertyInfo->units_set);
+		jsonWriterInteger(writer, "-value", propertyInfo->units_SI);
+		if(propertyInfo->redirectedVals && propertyInfo->redirectedUnits_SI_Prop)
+			jsonWriterInteger(writer, "-SIUnitsProperty", propertyInfo->redirectedUnits_SI_Prop);
+		jsonWriterEndObject(writer);
+	}
+
+	if(propertyInfo->units_set != 0 && propertyInfo->measurementType != 0)
+		writeSetValueMember(writer, "-MeasurementType", propertyInfo->units_set, propertyInfo->measurementType);
+
+	//A range with one zero bound is still a range
+	if(propertyInfo->min_IP != 0 || propertyInfo->max_IP != 0 || propertyInfo->redirectedMin_IP_Prop || propertyInfo->redirectedMax_IP_Prop)
+	{
+		jsonWriterBeginObject(writer, "-IPRange");
+		jsonWriterReal(writer, "-minvalue", propertyInfo->min_IP);
+		jsonWriterReal(writer, "-maxvalue", propertyInfo->max_IP);
+		if(propertyInfo->redirectedVals && propertyInfo->redirectedMin_IP_Prop)
+			jsonWriterInteger(writer, "-minProperty", propertyInfo->redirectedMin_IP_Prop);
+		if(propertyInfo->redirectedVals && propertyInfo->redirectedMax_IP_Prop)
+			jsonWriterInteger(writer, "-maxProperty", propertyInfo->redirectedMax_IP_Prop);
+		jsonWriterEndObject(writer);
+	}
+
+	if(propertyInfo->min_SI != 0 || propertyInfo->max_SI != 0 || propertyInfo->redirectedMin_SI_Prop || propertyInfo->redirectedMax_SI_Prop)
+	{
+		jsonWriterBeginObject(writer, "-SIRange");
+		jsonWriterReal(writer, "-minvalue", propertyInfo->min_SI);
+		jsonWriterReal(writer, "-maxvalue", propertyInfo->max_SI);
+		if(propertyInfo->redirectedVals && propertyInfo->redirectedMin_SI_Prop)
+			jsonWriterInteger(writer, "-minProperty", propertyInfo->redirectedMin_SI_Prop);
+		if(propertyInfo->redirectedVals && propertyInfo->redirectedMax_SI_Prop)
+			jsonWriterInteger(writer, "-maxProperty", propertyInfo->redirectedMax_SI_Prop);
+		jsonWriterEndObject(writer);
+	}
+
+	jsonWriterEndObject(writer);
+}
+
+/*------------------------------------------------------------------------------
+Module:   writeTemplateSubComponent method
+
+Purpose:  Writes one element of "-SubComponent".
+
+Inputs:   writer - Writer
+          subcomponentInfo - Subcomponent to write
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void writeTemplateSubComponent(JSON_WRITER * writer, const TEMPLATE_SUBCOMPONENT_INFO * subcomponentInfo)
+{
+	jsonWriterBeginObject(writer, NULL);
+
+	writeUnicodeMember(writer, "-Name", subcomponentInfo->subComponentId);
+	jsonWriterInteger(writer, "-Required", subcomponentInfo->subComponentRequired);
+
+	if(subcomponentInfo->subComponentSetId != 0 && subcomponentInfo->subComponentLabelValue != 0)
+		writeSetValueMember(writer, "-label", subcomponentInfo->subComponentSetId, subcomponentInfo->subComponentLabelValue);
+
+	writeUnicodeMember(writer, "-TemplateID", subcomponentInfo->templateId);
+
+	jsonWriterEndObject(writer);
+}
+
+/*------------------------------------------------------------------------------
+Module:   writeTemplate method
+
+Purpose:  Writes one element of "Template". All fields are read from the template
+          entry directly, no per field lookup.
+
+Inputs:   writer - Writer
+          templateHandle - Template to write
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void writeTemplate(JSON_WRITER * writer, TEMPLATE_HANDLE templateHandle)
+{
+	const TEMPLATE_SUBCOMPONENT_INFO_LIST * subComponentList = TEMPLATE_HANDLE_SUBCOMPONENT_LIST(templateHandle);
+	TEMPLATE_PROPERTY_ATTR_INFO propertyInfo;
+	UNSIGNED16 index;
+
+	jsonWriterBeginObject(writer, NULL);
+
+	jsonWriterInteger(writer, "-type", TEMPLATE_HANDLE_TYPE(templateHandle));
+	jsonWriterInteger(writer, "-subtype", TEMPLATE_HANDLE_SUBTYPE(templateHandle));
+	writeUnicodeMember(writer, "-extends", TEMPLATE_HANDLE_PARENT(templateHandle));
+	writeUnicodeMember(writer, "-description", TEMPLATE_HANDLE_DESCRIPTION(templateHandle));
+	writeUnicodeMember(writer, "-dictionary", TEMPLATE_HANDLE_DICTIONARY(templateHandle));
+	writeUnicodeMember(writer, "-ID", TEMPLATE_HANDLE_ID(templateHandle));
+	writeUnicodeMember(writer, "-name", TEMPLATE_HANDLE_NAME(templateHandle));
+
+	if(TEMPLATE_HANDLE_PRESENT_VALUE_ATTR_ID(templateHandle) >= 7000)
+		jsonWriterInteger(writer, "-presentValueAttributeId", TEMPLATE_HANDLE_PRESENT_VALUE_ATTR_ID(templateHandle));
+
+	//Like "-SubComponentList", left out when empty
+	if(TEMPLATE_HANDLE_NUM_PROPERTIES(templateHandle) > 0)
+	{
+		jsonWriterBeginObject(writer, "-PropertyList");
+		jsonWriterBeginArray(writer, "-Property");
+		for(index = 0; index < TEMPLATE_HANDLE_NUM_PROPERTIES(templateHandle); index++)
+		{
+			getTemplatePropertyRecord(templateHandle, index, &propertyInfo);
+			writeTemplateProperty(writer, &propertyInfo);
+		}
+		jsonWriterEndArray(writer);
+		jsonWriterEndObject(writer);
+	}
+
+	if(subComponentList->numSubComponentInfoEntries > 0)
+	{
+		jsonWriterBeginObject(writer, "-SubComponentList");
+		jsonWriterBeginArray(writer, "-SubComponent");
+		for(index = 0; index < subComponentList->numSubComponentInfoEntries; index++)
+			writeTemplateSubComponent(writer, &subComponentList->subComponentInfo[index]);
+		jsonWriterEndArray(writer);
+		jsonWriterEndObject(writer);
+	}
+
+	jsonWriterEndObject(writer);
+}
+
+/*------------------------------------------------------------------------------
+Module:   collectTemplates method
+
+Purpose:  Lists the templates of the database in templateId order, from one walk over
+          the template structure hash (the templateId is the hash key).
+
+Inputs:   templateDb - Template database
+
+Outputs:  templates - Template handles, release with OSrelease
+          numTemplates - Number of templates listed
+------------------------------------------------------------------------------*/
+static ERROR_STATUS collectTemplates(TEMPLATE_DATABASE * templateDb, TEMPLATE_HANDLE ** templates, UNSIGNED16 * numTemplates)
+{
+	APSHASHTBL * structureHash = templateDb->templateStructureHash;
+	struct hashEntry_s * templateNode;
+	TEMPLATE_HANDLE * slots;
+	UNSIGNED16 templateId, index, count = 0;
+	hashIndex idx;
+
+	*templates = NULL;
+	*numTemplates = 0;
+
+	if(templateDb->templateCount == 0)
+		return OK;
+
+	//One slot per templateId ever handed out, ids of failed templates stay empty
+	slots = (TEMPLATE_HANDLE *)OSacquire(sizeof(TEMPLATE_HANDLE) * templateDb->templateCount);
+	if(slots == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	OSmemset(slots, 0, sizeof(TEMPLATE_HANDLE) * templateDb->templateCount);
+
+	for(idx = 0; idx < structureHash->size; idx++)
+	{
+		for(templateNode = structureHash->nodes[idx]; templateNode != NULL; templateNode = templateNode->next)
+		{
+			templateId = *(UNSIGNED16 *)templateNode->key;
+			if(templateId >= 1 && templateId <= templateDb->templateCount)
+				slots[templateId - 1] = (TEMPLATE_HANDLE)templateNode->data;
+		}
+	}
+
+	for(index = 0; index < templateDb->templateCount; index++)
+		if(slots[index] != NULL)
+			slots[count++] = slots[index];
+
+	*templates = slots;
+	*numTemplates = count;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   ExportTemplateDatabase method
+
+Purpose:  Writes the template database as one template JSON document:
+          {"Version": ..., "Template": [ ... ]}
+          The templates are written in templateId (insertion) order, taken from one
+          walk over the template structure hash without a lookup per template.
+
+Inputs:   writer - Writer receiving the document
+          sinceGeneration - Only templates added after this database generation are
+                            written, 0 for all templates
+
+Outputs:  ERROR_STATUS, the writer's own errors are reported by jsonWriterFinish
+------------------------------------------------------------------------------*/
+ERROR_STATUS ExportTemplateDatabase(JSON_WRITER * writer, UNSIGNED32 sinceGeneration)
+{
+	TEMPLATE_DATABASE * templateDb = NULL;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+	TEMPLATE_HANDLE * templates = NULL;
+	UNSIGNED16 numTemplates = 0;
+	UNSIGNED16 index;
+	ERROR_STATUS status;
+
+	// get ptr to the model's class vars
+	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+	templateDb = classVarPtr->template_database;
+
+	if(templateDb == NULL || templateDb->templateStructureHash == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	status = collectTemplates(templateDb, &templates, &numTemplates);
+	if(status != OK)
+		return status;
+
+	jsonWriterBeginObject(writer, NULL);
+
+	writeUnicodeMember(writer, "Version", (TCHAR *)classVarPtr->template_Version);
+
+	jsonWriterBeginArray(writer, "Template");
+
+	for(index = 0; index < numTemplates && writer->status == OK; index++)
+		if(templates[index]->addedGeneration > sinceGeneration)
+			writeTemplate(writer, templates[index]);
+
+	jsonWriterEndArray(writer);
+	jsonWriterEndObject(writer);
+
+	if(templates != NULL)
+		OSrelease(templates);
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   partitionSink method
+
+Purpose:  Writer sink of a parallel export partition: counts the output while the
+          partition is measured, then places it in the partition's slice.
+
+Inputs:   sinkContext - TEMPLATE_EXPORT_PARTITION
+          data, length - Output to take
+
+Outputs:  ERROR_STATUS, ERROR_RESPONSE if the output outgrows its measured length
+------------------------------------------------------------------------------*/
+static ERROR_STATUS partitionSink(void * sinkContext, const UNSIGNED8 * data, UNSIGNED32 length)
+{
+	TEMPLATE_EXPORT_PARTITION * partition = (TEMPLATE_EXPORT_PARTITION *)sinkContext;
+
+	if(partition->slice != NULL)
+	{
+		if(partition->written + length > partition->length)
+			return ERROR_RESPONSE;
+
+		OSmemcpy(partition->slice + partition->written, data, length);
+	}
+
+	partition->written += length;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   exportPartitionTask method
+
+Purpose:  Task of a parallel export: serializes the templates of one partition,
+          comma separated, through a staging buffer into partitionSink. Only reads
+          the template database.
+
+Inputs:   taskContext - TEMPLATE_EXPORT_PARTITION
+
+Outputs:  None, errors are kept in the partition's status
+------------------------------------------------------------------------------*/
+static void exportPartitionTask(void * taskContext)
+{
+	TEMPLATE_EXPORT_PARTITION * partition = (TEMPLATE_EXPORT_PARTITION *)taskContext;
+	JSON_WRITER writer;
+	UNSIGNED16 index;
+
+	partition->written = 0;
+
+	jsonWriterInit(&writer, partitionSink, partition);
+
+	for(index = 0; index < partition->numTemplates && writer.status == OK; index++)
+		writeTemplate(&writer, partition->templates[index]);
+
+	partition->status = jsonWriterFinish(&writer);
+	jsonWriterRelease(&writer);
+}
+
+/*------------------------------------------------------------------------------
+Module:   CreateNewTemplateParallel method
+
+Purpose:  This is a public accessible method, serializes the template database like
+          CreateNewTemplate with the templates split across workers. The templates
+          are taken in templateId order and cut into numWorkers contiguous
+          partitions, each serialized by a task given to the dispatcher. The tasks
+          run twice: first to measure each partition, then, with the output
+          acquired once at its final size, to write each partition straight into its
+          own slice of it. The output is laid out in partition order, so it does not
+          depend on the scheduling, and it is never held twice. The template
+          database must not be modified while the export runs.
+
+Inputs:   numWorkers - Number of partitions, 1 to TASK_DISPATCH_MAX_WORKERS
+          dispatch - Runs the partition tasks, NULL for the default dispatcher
+
+Outputs:  newTemplate - NUL terminated JSON string, acquired with the jansson
+                        allocator, released as the CreateNewTemplate output
+------------------------------------------------------------------------------*/
+ERROR_STATUS CreateNewTemplateParallel(UNSIGNED16 numWorkers, TASK_DISPATCH dispatch, char ** newTemplate)
+{
+	TEMPLATE_DATABASE * templateDb = NULL;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+	TEMPLATE_EXPORT_PARTITION * partitions = NULL;
+	void * taskContexts[TASK_DISPATCH_MAX_WORKERS];
+	TEMPLATE_HANDLE * templates = NULL;
+	UNSIGNED16 numTemplates = 0;
+	UNSIGNED16 index, first;
+	UNSIGNED32 headerLength, totalLength, offset;
+	UNSIGNED8 * output = NULL;
+	json_malloc_t jsonMalloc;
+	json_free_t jsonFree;
+	JSON_WRITER writer;
+	ERROR_STATUS status;
+
+	*newTemplate = NULL;
+
+	// get ptr to the model's class vars
+	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+	templateDb = classVarPtr->template_database;
+
+	if(templateDb == NULL || templateDb->templateStructureHash == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	if(dispatch == NULL)
+		dispatch = DefaultTaskDispatch;
+
+	status = collectTemplates(templateDb, &templates, &numTemplates);
+	if(status != OK)
+		return status;
+
+	if(numWorkers > TASK_DISPATCH_MAX_WORKERS)
+		numWorkers = TASK_DISPATCH_MAX_WORKERS;
+	if(numWorkers > numTemplates)
+		numWorkers = numTemplates;
+	if(numWorkers == 0)
+		numWorkers = 1;
+
+	partitions = (TEMPLATE_EXPORT_PARTITION *)OSacquire(sizeof(TEMPLATE_EXPORT_PARTITION) * numWorkers);
+	if(partitions == NULL)
+	{
+		if(templates != NULL)
+			OSrelease(templates);
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	//Step - 1: Contiguous partitions of near equal size, measured
+	for(index = 0, first = 0; index < numWorkers; index++)
+	{
+		partitions[index].templates = templates + first;
+		partitions[index].numTemplates = (UNSIGNED16)((UNSIGNED32)numTemplates * (index + 1) / numWorkers) - first;
+		partitions[index].slice = NULL;
+		partitions[index].status = OK;
+		first += partitions[index].numTemplates;
+
+		taskContexts[index] = &partitions[index];
+	}
+
+	status = dispatch(exportPartitionTask, taskContexts, numWorkers);
+
+	//Step - 2: Document head and tail around the partitions, the tail follows the
+	//head in the writer's buffer
+	jsonWriterInit(&writer, NULL, NULL);
+
+	jsonWriterBeginObject(&writer, NULL);
+	writeUnicodeMember(&writer, "Version", (TCHAR *)classVarPtr->template_Version);
+	jsonWriterBeginArray(&writer, "Template");
+	headerLength = writer.length;
+	jsonWriterEndArray(&writer);
+	jsonWriterEndObject(&writer);
+
+	if(status == OK)
+		status = jsonWriterFinish(&writer);
+
+	//Step - 3: Output acquired once at its final size, partitions comma separated (room
+	//is kept for a comma before each)
+	totalLength = writer.length + 1;
+	for(index = 0; index < numWorkers && status == OK; index++)
+	{
+		status = partitions[index].status;
+		partitions[index].length = partitions[index].written;
+		if(partitions[index].length > 0)
+			totalLength += partitions[index].length + 1;
+	}
+
+	if(status == OK)
+	{
+		json_get_alloc_funcs(&jsonMalloc, &jsonFree);
+
+		output = (UNSIGNED8 *)jsonMalloc(totalLength);
+		if(output == NULL)
+			status = NOT_ENOUGH_MEMORY;
+	}
+
+	if(status == OK)
+	{
+		OSmemcpy(output, writer.buffer, headerLength);
+		offset = headerLength;
+
+		for(index = 0; index < numWorkers; index++)
+		{
+			if(partitions[index].length == 0)
+				continue;
+
+			if(offset > headerLength)
+				output[offset++] = ',';
+
+			partitions[index].slice = output + offset;
+			offset += partitions[index].length;
+		}
+
+		//The tail with its NUL terminator
+		OSmemcpy(output + offset, writer.buffer + headerLength, writer.length - headerLength + 1);
+
+		//Step - 4: Partitions written into their slices
+		status = dispatch(exportPartitionTask, taskContexts, numWorkers);
+
+		for(index = 0; index < numWorkers && status == OK; index++)
+		{
+			status = partitions[index].status;
+			if(status == OK && partitions[index].written != partitions[index].length)
+				status = ERROR_RESPONSE;
+		}
+
+		if(status != OK)
+			jsonFree(output);
+	}
+
+	jsonWriterRelease(&writer);
+
+	OSrelease(partitions);
+	if(templates != NULL)
+		OSrelease(templates);
+
+	if(status == OK)
+		*newTemplate = (char *)output;
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   fileSink method
+
+Purpose:  Writer sink appending the output to an open file.
+
+Inputs:   sinkContext - File handle
+          data, length - Output to append
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+static ERROR_STATUS fileSink(void * sinkContext, const UNSIGNED8 * data, UNSIGNED32 length)
+{
+	if(OSFileWrite(data, sizeof(UNSIGNED8), length, sinkContext) != length)
+		return ERROR_RESPONSE;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   ExportTemplateFile method
+
+Purpose:  This is a public accessible method, writes the template database as one
+          template JSON file. The output goes through a JSON_WRITER_BUFFER_SIZE
+          staging buffer, the document is never held in memory as a whole.
+
+Inputs:   filePath - Path of the file to write
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS ExportTemplateFile(TCHAR * filePath)
+{
+	JSON_WRITER writer;
+	TCHAR wb_filemode[] = {(TCHAR)'w', (TCHAR)'b', (TCHAR)'\0'};
+	void * pFile;
+	ERROR_STATUS status;
+
+	pFile = OSFileOpen(filePath, wb_filemode);
+	if(pFile == NULL)
+		return FILE_NOT_FOUND;
+
+	jsonWriterInit(&writer, fileSink, pFile);
+
+	status = ExportTemplateDatabase(&writer, 0);
+	if(status == OK)
+		status = jsonWriterFinish(&writer);
+
+	jsonWriterRelease(&writer);
+	OSFileClose(pFile);
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jzDeflate method
+
+Purpose:  Runs input through the compressor and writes every compressed block to
+          the file.
+
+Inputs:   jzSink - Compressor state and file
+          data, length - Input, may be empty when finishing
+          flush - Z_NO_FLUSH, or Z_FINISH to complete the stream
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+static ERROR_STATUS jzDeflate(JZ_SINK * jzSink, const UNSIGNED8 * data, UNSIGNED32 length, int flush)
+{
+	UNSIGNED32 produced;
+	int result;
+
+	jzSink->stream.next_in = (Bytef *)data;
+	jzSink->stream.avail_in = length;
+
+	do
+	{
+		jzSink->stream.next_out = jzSink->output;
+		jzSink->stream.avail_out = sizeof(jzSink->output);
+
+		result = deflate(&jzSink->stream, flush);
+		if(result == Z_STREAM_ERROR)
+			return ERROR_RESPONSE;
+
+		produced = sizeof(jzSink->output) - jzSink->stream.avail_out;
+		if(produced > 0 && OSFileWrite(jzSink->output, sizeof(UNSIGNED8), produced, jzSink->pFile) != produced)
+			return ERROR_RESPONSE;
+
+	} while(jzSink->stream.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   jzSink method
+
+Purpose:  Writer sink compressing the output into a .jz file.
+
+Inputs:   sinkContext - JZ_SINK
+          data, length - Output to compress
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+static ERROR_STATUS jzSink(void * sinkContext, const UNSIGNED8 * data, UNSIGNED32 length)
+{
+	return jzDeflate((JZ_SINK *)sinkContext, data, length, Z_NO_FLUSH);
+}
+
+/*------------------------------------------------------------------------------
+Module:   ExportTemplateCompressedFile method
+
+Purpose:  This is a public accessible method, writes the template database as one
+          compressed template file (.jz, readable by ReadTemplateFileFromPath). The
+          document is compressed as it is written, one JSON_WRITER_BUFFER_SIZE
+          staging buffer at a time, the uncompressed document is never held in
+          memory.
+
+Inputs:   filePath - Path of the .jz file to write
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS ExportTemplateCompressedFile(TCHAR * filePath)
+{
+	JSON_WRITER writer;
+	JZ_SINK * jzSinkState;
+	TCHAR wb_filemode[] = {(TCHAR)'w', (TCHAR)'b', (TCHAR)'\0'};
+	ERROR_STATUS status;
+
+	jzSinkState = (JZ_SINK *)OSacquire(sizeof(JZ_SINK));
+	if(jzSinkState == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	OSmemset(jzSinkState, 0, sizeof(JZ_SINK));
+
+	if(deflateInit2(&jzSinkState->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, JZ_WINDOW_BITS, JZ_MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		OSrelease(jzSinkState);
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	jzSinkState->pFile = OSFileOpen(filePath, wb_filemode);
+	if(jzSinkState->pFile == NULL)
+	{
+		deflateEnd(&jzSinkState->stream);
+		OSrelease(jzSinkState);
+		return FILE_NOT_FOUND;
+	}
+
+	jsonWriterInit(&writer, jzSink, jzSinkState);
+
+	status = ExportTemplateDatabase(&writer, 0);
+	if(status == OK)
+		status = jsonWriterFinish(&writer);
+
+	if(status == OK)
+		status = jzDeflate(jzSinkState, NULL, 0, Z_FINISH);
+
+	jsonWriterRelease(&writer);
+	deflateEnd(&jzSinkState->stream);
+	OSFileClose(jzSinkState->pFile);
+	OSrelease(jzSinkState);
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   MarkTemplateAdded method
+
+Purpose:  Starts a new database generation for a template just added to the
+          database and stamps the template with it. The cached export is outdated
+          from then on. Called as soon as the template is in the structure hash,
+          before anything else can fail, so the export never changes without a new
+          generation.
+
+Inputs:   templateDb - Template database (allocated as TEMPLATE_DATABASE_EXT)
+          templateId - Template Id (key in templateStructureHash)
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS MarkTemplateAdded(TEMPLATE_DATABASE * templateDb, UNSIGNED16 templateId)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = (TEMPLATE_DATABASE_EXT *)templateDb;
+	TEMPLATE_ENTRY_EXT * entryExt = NULL;
+
+	if(templateDbExt == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	if(hashtbl_get(templateDb->templateStructureHash, &templateId, sizeof(templateId), (void **)&entryExt))
+		return TEMPLATE_NOT_FOUND;
+
+	entryExt->addedGeneration = ++templateDbExt->generation;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplateGeneration method
+
+Purpose:  This is a public accessible method, returns the current generation of the
+          template database. It changes whenever templates are added or dropped.
+
+Inputs:   None
+
+Outputs:  generation - Current database generation
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplateGeneration(UNSIGNED32 * generation)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = NULL;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+
+	// get ptr to the model's class vars
+	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+	templateDbExt = (TEMPLATE_DATABASE_EXT *)classVarPtr->template_database;
+	if(templateDbExt == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	*generation = templateDbExt->generation;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplateExport method
+
+Purpose:  This is a public accessible method, returns the template JSON document of
+          the whole database. The document is cached with the generation it was
+          written at and only written again once the database changed.
+
+Inputs:   None
+
+Outputs:  templateExport - Document with its length and generation, read-only. The
+                           caller holds a reference and gives it back with
+                           ReleaseTemplateExport.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplateExport(TEMPLATE_EXPORT ** templateExport)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = NULL;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+	TEMPLATE_EXPORT * exportCache;
+	JSON_WRITER writer;
+	ERROR_STATUS status;
+
+	*templateExport = NULL;
+
+	// get ptr to the model's class vars
+	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+	templateDbExt = (TEMPLATE_DATABASE_EXT *)classVarPtr->template_database;
+	if(templateDbExt == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	if(templateDbExt->exportCache == NULL || templateDbExt->exportCache->generation != templateDbExt->generation)
+	{
+		exportCache = (TEMPLATE_EXPORT *)OSacquire(sizeof(TEMPLATE_EXPORT));
+		if(exportCache == NULL)
+			return NOT_ENOUGH_MEMORY;
+
+		jsonWriterInit(&writer, NULL, NULL);
+
+		status = ExportTemplateDatabase(&writer, 0);
+		if(status == OK)
+			status = jsonWriterFinish(&writer);
+
+		if(status != OK)
+		{
+			jsonWriterRelease(&writer);
+			OSrelease(exportCache);
+			return status;
+		}
+
+		exportCache->refCount = 1;
+		exportCache->generation = templateDbExt->generation;
+		exportCache->length = writer.length;
+		exportCache->data = jsonWriterDetach(&writer);
+
+		//Holders of the previous document keep it until they release it
+		ReleaseTemplateExportCache(&templateDbExt->database);
+		templateDbExt->exportCache = exportCache;
+	}
+
+	templateDbExt->exportCache->refCount++;
+	*templateExport = templateDbExt->exportCache;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   ReleaseTemplateExport method
+
+Purpose:  This is a public accessible method, gives back a reference on a document
+          returned by GetTemplateExport. The document is released with its last
+          reference.
+
+Inputs:   templateExport - Document, may be NULL
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+void ReleaseTemplateExport(TEMPLATE_EXPORT * templateExport)
+{
+	json_malloc_t jsonMalloc;
+	json_free_t jsonFree;
+
+	if(templateExport == NULL || --templateExport->refCount > 0)
+		return;
+
+	if(templateExport->data != NULL)
+	{
+		json_get_alloc_funcs(&jsonMalloc, &jsonFree);
+		jsonFree(templateExport->data);
+	}
+
+	OSrelease(templateExport);
+}
+
+/*------------------------------------------------------------------------------
+Module:   ReleaseTemplateExportCache method
+
+Purpose:  Drops the database's reference on its cached export, when the database is
+          torn down or its content replaced. Documents still held by callers stay
+          valid until they are released.
+
+Inputs:   templateDb - Template database (allocated as TEMPLATE_DATABASE_EXT)
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+void ReleaseTemplateExportCache(TEMPLATE_DATABASE * templateDb)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = (TEMPLATE_DATABASE_EXT *)templateDb;
+
+	if(templateDbExt == NULL)
+		return;
+
+	ReleaseTemplateExport(templateDbExt->exportCache);
+	templateDbExt->exportCache = NULL;
+}
+
+/*------------------------------------------------------------------------------
+Module:   CreateTemplateDelta method
+
+Purpose:  This is a public accessible method, serializes only the templates added
+          after a given database generation, in the same document layout as
+          CreateNewTemplate. A caller keeps the returned generation and passes it on
+          the next call; an empty "Template" array means nothing was added.
+
+Inputs:   sinceGeneration - Generation returned by the previous export, 0 for all
+
+Outputs:  delta - NUL terminated JSON string, acquired with the jansson allocator,
+                  released as the CreateNewTemplate output
+          generation - Database generation the delta is current to
+------------------------------------------------------------------------------*/
+ERROR_STATUS CreateTemplateDelta(UNSIGNED32 sinceGeneration, char ** delta, UNSIGNED32 * generation)
+{
+	JSON_WRITER writer;
+	ERROR_STATUS status;
+
+	*delta = NULL;
+
+	status = GetTemplateGeneration(generation);
+	if(status != OK)
+		return status;
+
+	jsonWriterInit(&writer, NULL, NULL);
+
+	status = ExportTemplateDatabase(&writer, sinceGeneration);
+	if(status == OK)
+		status = jsonWriterFinish(&writer);
+
+	if(status != OK)
+	{
+		jsonWriterRelease(&writer);
+		return status;
+	}
+
+	*delta = (char *)jsonWriterDetach(&writer);
+
+	return OK;
+}
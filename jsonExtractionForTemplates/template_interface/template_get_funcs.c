@@ -51,6 +51,255 @@ ERROR_STATUS getTemplateInfo(UNSIGNED16 templateId, TEMPLATE_ENTRY ** templateIn
 	return OK;
 }
 
+/*------------------------------------------------------------------------------
+Module:   templatePropertyMayExist method
+
+Purpose:  This is a private method and used internally. Tests an attribute Id against
+the template's membership filter. FALSE means the template does not have the attribute;
+TRUE is exact for a bitset filter and may be a false positive for a Bloom filter.
+
+Inputs:   Template entry
+		  Property Attribute ID to test
+
+Outputs:  TRUE or FALSE
+------------------------------------------------------------------------------*/
+static UNSIGNED8 templatePropertyMayExist(TEMPLATE_ENTRY_EXT * entryExt, UNSIGNED16 attrId)
+{
+	const TEMPLATE_MEMBERSHIP_FILTER * membership = &entryExt->membership;
+	UNSIGNED32 hash, bits;
+	UNSIGNED16 offset;
+
+	if(membership->bits == NULL)
+		return FALSE;
+
+	if(membership->span)
+	{
+		//Ids below the base wrap around to a large offset
+		offset = (UNSIGNED16)(attrId - membership->base);
+		return (offset < membership->span && (membership->bits[offset / 32] & (1UL << (offset % 32)))) ? TRUE : FALSE;
+	}
+
+	hash = TEMPLATE_MEMBERSHIP_HASH(attrId);
+	bits = TEMPLATE_MEMBERSHIP_BITS(hash);
+	return ((membership->bits[TEMPLATE_MEMBERSHIP_BLOCK(hash, membership->blockMask)] & bits) == bits) ? TRUE : FALSE;
+}
+
+/*------------------------------------------------------------------------------
+Module:   findTemplatePropertyIndex method
+
+Purpose:  This is a private method and used internally. Looks up a property in the
+template's attribute Id column (sorted) with a branch-free binary search.
+
+Inputs:   Template entry
+		  Property Attribute ID to look up
+
+Outputs:  Index of the property in the template's property columns, -1 if not found
+------------------------------------------------------------------------------*/
+SIGNED32 findTemplatePropertyIndex(const TEMPLATE_ENTRY_EXT * entryExt, UNSIGNED16 attrId)
+{
+	const UNSIGNED16 * base = entryExt->propertyAttrIds;
+	UNSIGNED16 count = entryExt->numProperties;
+	UNSIGNED16 half;
+
+	//Attributes the template does not have are mostly rejected by the membership filter
+	if(!templatePropertyMayExist((TEMPLATE_ENTRY_EXT *)entryExt, attrId))
+		return -1;
+
+	//The comparison only selects the next base, no branch on the data
+	while(count > 1)
+	{
+		half = count / 2;
+		base = (base[half] <= attrId) ? base + half : base;
+		count -= half;
+	}
+
+	if(*base != attrId)
+		return -1;
+
+	return (SIGNED32)(base - entryExt->propertyAttrIds);
+}
+
+/*------------------------------------------------------------------------------
+Module:   getTemplatePropertyRecord method
+
+Purpose:  This is a private method and used internally. Puts a property record
+together from the template's property columns and cold array.
+
+Inputs:   Template entry
+		  Index of the property in the template's property columns
+
+Outputs:  propertyInfo - Record to fill
+------------------------------------------------------------------------------*/
+void getTemplatePropertyRecord(const TEMPLATE_ENTRY_EXT * entryExt, UNSIGNED16 index, TEMPLATE_PROPERTY_ATTR_INFO * propertyInfo)
+{
+	const TEMPLATE_PROPERTY_COLD_INFO * coldInfo = &entryExt->propertyColdInfo[index];
+	UNSIGNED8 flags = entryExt->propertyFlags[index];
+
+	OSmemset(propertyInfo, 0, sizeof(TEMPLATE_PROPERTY_ATTR_INFO));
+
+	propertyInfo->attrID = entryExt->propertyAttrIds[index];
+	propertyInfo->dataType = entryExt->propertyDataTypes[index];
+	propertyInfo->attrWritable = (flags & TEMPLATE_PROPERTY_FLAG_WRITABLE) ? 1 : 0;
+	propertyInfo->attrPriority = (flags & TEMPLATE_PROPERTY_FLAG_PRIORITY) ? 1 : 0;
+	propertyInfo->required = (flags & TEMPLATE_PROPERTY_FLAG_REQUIRED) ? 1 : 0;
+
+	propertyInfo->min_IP = coldInfo->min_IP;
+	propertyInfo->max_IP = coldInfo->max_IP;
+	propertyInfo->min_SI = coldInfo->min_SI;
+	propertyInfo->max_SI = coldInfo->max_SI;
+	propertyInfo->enumSet = coldInfo->enumSet;
+	propertyInfo->redirectedEnumSetProp = coldInfo->redirectedEnumSetProp;
+	propertyInfo->dispPrec_IP = coldInfo->dispPrec_IP;
+	propertyInfo->dispPrec_SI = coldInfo->dispPrec_SI;
+	propertyInfo->attrNameset = coldInfo->attrNameset;
+	propertyInfo->attrName = coldInfo->attrName;
+	propertyInfo->attrDescriptionset = coldInfo->attrDescriptionset;
+	propertyInfo->attrDescription = coldInfo->attrDescription;
+	propertyInfo->units_set = coldInfo->units_set;
+	propertyInfo->units_IP = coldInfo->units_IP;
+	propertyInfo->units_SI = coldInfo->units_SI;
+	propertyInfo->measurementType = coldInfo->measurementType;
+	propertyInfo->redirectedUnits_IP_Prop = coldInfo->redirectedUnits_IP_Prop;
+	propertyInfo->redirectedUnits_SI_Prop = coldInfo->redirectedUnits_SI_Prop;
+	propertyInfo->redirectedMin_IP_Prop = coldInfo->redirectedMin_IP_Prop;
+	propertyInfo->redirectedMax_IP_Prop = coldInfo->redirectedMax_IP_Prop;
+	propertyInfo->redirectedMin_SI_Prop = coldInfo->redirectedMin_SI_Prop;
+	propertyInfo->redirectedMax_SI_Prop = coldInfo->redirectedMax_SI_Prop;
+	propertyInfo->redirectedVals = coldInfo->redirectedVals;
+	propertyInfo->maxStringLength = coldInfo->maxStringLength;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getTemplatePropertyRecords method
+
+Purpose:  This is a private method and used internally. Builds the template's property
+records (propertyList, same order as the columns) and its attribute hash the first
+time a getter hands out a record. Templates only scanned or exported never get them.
+
+Inputs:   Template entry
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS getTemplatePropertyRecords(TEMPLATE_ENTRY_EXT * entryExt)
+{
+	TEMPLATE_PROPERTY_ATTR_INFO * propertyArray;
+	UNSIGNED16 index;
+	ERROR_STATUS status;
+
+	if(entryExt->propertyList.propertyInfo != NULL || entryExt->numProperties == 0)
+		return OK;
+
+	propertyArray = (TEMPLATE_PROPERTY_ATTR_INFO *)OSacquire(sizeof(TEMPLATE_PROPERTY_ATTR_INFO) * entryExt->numProperties);
+	if(propertyArray == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	for(index = 0; index < entryExt->numProperties; index++)
+	{
+		getTemplatePropertyRecord(entryExt, index, &propertyArray[index]);
+
+		if(entryExt->entry.templateAttrInfo != NULL)
+		{
+			status = hashtbl_insert(entryExt->entry.templateAttrInfo, &propertyArray[index].attrID, &propertyArray[index], sizeof(propertyArray[index].attrID));
+			if(status != OK)
+			{
+				//Take the records inserted so far back out
+				while(index-- > 0)
+					hashtbl_remove(entryExt->entry.templateAttrInfo, &propertyArray[index].attrID, sizeof(propertyArray[index].attrID));
+
+				OSrelease(propertyArray);
+				return status;
+			}
+		}
+	}
+
+	entryExt->propertyList.numtemplatePropertyInfoEntries = entryExt->numProperties;
+	entryExt->propertyList.propertyInfo = propertyArray;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   findTemplateProperty method
+
+Purpose:  This is a private method and used internally. Looks up a property of the
+template and returns its record, building the template's records on first use.
+
+Inputs:   Template Info structure
+		  Property Attribute ID to look up
+
+Outputs:  Pointer to the property record within the template, NULL if not found or if
+the records could not be built
+------------------------------------------------------------------------------*/
+TEMPLATE_PROPERTY_ATTR_INFO * findTemplateProperty(TEMPLATE_ENTRY * templateInfo, UNSIGNED16 attrId)
+{
+	TEMPLATE_ENTRY_EXT * entryExt = (TEMPLATE_ENTRY_EXT *)templateInfo;
+	SIGNED32 index;
+
+	index = findTemplatePropertyIndex(entryExt, attrId);
+	if(index < 0 || getTemplatePropertyRecords(entryExt) != OK)
+		return NULL;
+
+	return &entryExt->propertyList.propertyInfo[index];
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplateHandle method
+
+Purpose:  This is a public accessible method, returns a handle on the template for a
+given template Id. Callers reading several fields of a template get the handle once
+and use the TEMPLATE_HANDLE_xxx accessors, paying a single template lookup.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+from hash
+
+Outputs:  Template handle, valid as long as the template database exists.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplateHandle(UNSIGNED16 templateId, TEMPLATE_HANDLE * templateHandle)
+{
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
+
+	if(!errorStatus)
+	{
+		*templateHandle = (TEMPLATE_HANDLE)templateInfo;
+		return OK;
+	}
+
+	return errorStatus;
+}
+
+/*------------------------------------------------------------------------------
+Module:   TemplateHasProperty method
+
+Purpose:  This is a public accessible method, tells whether a template has a given
+property. Cheaper than probing GetTemplatePropertyInfo: most absent attributes are
+answered by the template's membership filter alone.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+from hash
+		  Property Attribute ID to test
+
+Outputs:  hasProperty - TRUE or FALSE
+		  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS TemplateHasProperty(UNSIGNED16 templateId, UNSIGNED16 attrId, UNSIGNED8 * hasProperty)
+{
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
+
+	if(!errorStatus)
+	{
+		*hasProperty = (findTemplatePropertyIndex((TEMPLATE_ENTRY_EXT *)templateInfo, attrId) >= 0) ? TRUE : FALSE;
+		return OK;
+	}
+
+	return errorStatus;
+}
+
 /*------------------------------------------------------------------------------
 Module:   GetTemplateType method
 
@@ -228,108 +477,222 @@ Inputs:   Template Id key from which the template Information needs to be retrie
       be filled in since the actual redirected value needs to be read from a
       specified/particular equipment object instance.
 
-Outputs:  Pointer to Template Property Info Structure
+Outputs:  Pointer to Template Property Info Structure. For a property with redirected
+      values and an equipment object, this is the object's own copy; it is read again
+      on the next call unless the object enabled the cache (then after
+      InvalidateTemplateInstanceCache) and released by ReleaseTemplateInstanceCache.
 ------------------------------------------------------------------------------*/
 ERROR_STATUS  GetTemplatePropertyInfo(UNSIGNED16 templateId, UNSIGNED16 attrId, OID_TYPE equipObjId, TEMPLATE_PROPERTY_ATTR_INFO** templatePropertyInfo)
 {
 	TEMPLATE_ENTRY * templateInfo = NULL;
+	TEMPLATE_ENTRY_EXT * entryExt;
+	SIGNED32 index;
 	ERROR_STATUS errorStatus;
 
 	errorStatus = getTemplateInfo(templateId, &templateInfo);
 
 	if(!errorStatus)
 	{
+		entryExt = (TEMPLATE_ENTRY_EXT *)templateInfo;
+
 		//Get the template property info
-		if(templateInfo->templateAttrInfo == NULL)
+		index = findTemplatePropertyIndex(entryExt, attrId);
+		if(index < 0)
 			return TEMPLATE_PROPERTY_NOT_FOUND;
-	
-		if(hashtbl_get(templateInfo->templateAttrInfo, &attrId, sizeof(attrId), (void **)templatePropertyInfo))
-			return TEMPLATE_PROPERTY_NOT_FOUND;
-    else //Get any redirected values for min/max, units, or enum set
-    {
-      TEMPLATE_PROPERTY_ATTR_INFO * attrInfo;
-      attrInfo = *templatePropertyInfo;
-      if (equipObjId && attrInfo->redirectedVals)
-      {
-        PARM_DATA parm;
-        ERROR_STATUS readStatus;
-        if (attrInfo->redirectedEnumSetProp)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedEnumSetProp, &parm, ENUM_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->enumSet = parm.parmValue.tEnum;
-        }
-        if (attrInfo->redirectedUnits_IP_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedUnits_IP_Prop, &parm, ENUM_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->units_IP = parm.parmValue.tEnum;
-        }
-        if (attrInfo->redirectedUnits_SI_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedUnits_SI_Prop, &parm, ENUM_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->units_SI = parm.parmValue.tEnum;
-        }
-#ifdef USE_DOUBLE
-        if (attrInfo->redirectedMin_IP_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMin_IP_Prop, &parm, DOUBLE_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->min_IP = parm.parmValue.tDouble;
-        }
-        if (attrInfo->redirectedMax_IP_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMax_IP_Prop, &parm, DOUBLE_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->max_IP = parm.parmValue.tDouble;
-        }
-        if (attrInfo->redirectedMin_SI_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMin_SI_Prop, &parm, DOUBLE_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->min_SI = parm.parmValue.tDouble;
-        }
-        if (attrInfo->redirectedMax_SI_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMax_SI_Prop, &parm, DOUBLE_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->max_SI = parm.parmValue.tDouble;
-        }
-#else
-        if (attrInfo->redirectedMin_IP_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMin_IP_Prop, &parm, FLOAT_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->min_IP = parm.parmValue.tFloat;
-        }
-        if (attrInfo->redirectedMax_IP_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMax_IP_Prop, &parm, FLOAT_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->max_IP = parm.parmValue.tFloat;
-        }
-        if (attrInfo->redirectedMin_SI_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMin_SI_Prop, &parm, FLOAT_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->min_SI = parm.parmValue.tFloat;
-        }
-        if (attrInfo->redirectedMax_SI_Prop)
-        {
-          readStatus = stdReadInternalAttr(equipObjId, attrInfo->redirectedMax_SI_Prop, &parm, FLOAT_DATA_TYPE);
-          if (readStatus == OK)
-            attrInfo->max_SI = parm.parmValue.tFloat;
-        }
-#endif
-      }
-    }
+
+		errorStatus = getTemplatePropertyRecords(entryExt);
+		if(errorStatus != OK)
+			return errorStatus;
+
+		*templatePropertyInfo = &entryExt->propertyList.propertyInfo[index];
+
+		//Redirected values for min/max, units, or enum set are read from the equipment
+		//object into a per-instance copy, the template's structure is left untouched
+		if (equipObjId && (*templatePropertyInfo)->redirectedVals)
+			return getTemplateInstancePropertyInfo(equipObjId, templateId, *templatePropertyInfo, templatePropertyInfo);
 
 		return OK;
 	}
 	
 	return errorStatus;	
 }
+/*------------------------------------------------------------------------------
+Module:   GetTemplatePropertyInfoList method
+
+Purpose:  This is a public accessible method, batch form of GetTemplatePropertyInfo.
+Returns the template property info of several attributes of a template in one call:
+the template is looked up once and the redirected values of all the properties are
+read in one pass, each source attribute of the equipment object being read only once.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+			from hash
+		  Array of Property Attribute IDs and its number of entries
+      Internal OID (jci oid) of the equipment object for which the info is
+      requested, NONE(0) for the template values (see GetTemplatePropertyInfo).
+
+Outputs:  Array (numAttrIds entries, allocated by the caller) filled with the pointers
+GetTemplatePropertyInfo would return. An attribute not in the template gets NULL and
+TEMPLATE_PROPERTY_NOT_FOUND is returned once the other entries are filled. On any other
+error every entry is NULL.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplatePropertyInfoList(UNSIGNED16 templateId, UNSIGNED16 * attrIds, UNSIGNED16 numAttrIds, OID_TYPE equipObjId, TEMPLATE_PROPERTY_ATTR_INFO ** templatePropertyInfos)
+{
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	TEMPLATE_ENTRY_EXT * entryExt;
+	SIGNED32 propertyIndex;
+	ERROR_STATUS errorStatus;
+	ERROR_STATUS status = OK;
+	UNSIGNED16 index;
+
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
+
+	if(!errorStatus)
+	{
+		entryExt = (TEMPLATE_ENTRY_EXT *)templateInfo;
+
+		errorStatus = getTemplatePropertyRecords(entryExt);
+		if(errorStatus != OK)
+		{
+			OSmemset(templatePropertyInfos, 0, sizeof(TEMPLATE_PROPERTY_ATTR_INFO *) * numAttrIds);
+			return errorStatus;
+		}
+
+		for(index = 0; index < numAttrIds; index++)
+		{
+			propertyIndex = findTemplatePropertyIndex(entryExt, attrIds[index]);
+			if(propertyIndex < 0)
+			{
+				templatePropertyInfos[index] = NULL;
+				status = TEMPLATE_PROPERTY_NOT_FOUND;
+			}
+			else
+			{
+				templatePropertyInfos[index] = &entryExt->propertyList.propertyInfo[propertyIndex];
+			}
+		}
+
+		//Swap the properties with redirected values for the equipment object's copies
+		if(equipObjId)
+		{
+			errorStatus = getTemplateInstancePropertyInfoList(equipObjId, templateId, templatePropertyInfos, numAttrIds);
+			if(errorStatus != OK)
+			{
+				OSmemset(templatePropertyInfos, 0, sizeof(TEMPLATE_PROPERTY_ATTR_INFO *) * numAttrIds);
+				return errorStatus;
+			}
+		}
+
+		return status;
+	}
+
+	return errorStatus;
+}
+
+/*------------------------------------------------------------------------------
+Module:   scanTemplatePropertyColumn method
+
+Purpose:  This is a private method and used internally. Collects the attribute Ids of
+the properties whose column value, masked, equals a given value. When the output array
+can hold every property of the template the loop has no data-dependent branch (the Id
+is always stored, the count only advances on a match) so the compiler can vectorize it
+over the byte column; a smaller array is filled with a bounds check.
+
+Inputs:   Template Info structure
+		  Column to scan (one byte per property), mask and expected value
+		  Output array and its size
+
+Outputs:  Attribute Ids of the matching properties in attribute Id order (at most
+maxAttrIds), and the number of matching properties. ERROR_RESPONSE if that number
+is larger than maxAttrIds, the array then holds the first maxAttrIds of them.
+------------------------------------------------------------------------------*/
+static ERROR_STATUS scanTemplatePropertyColumn(TEMPLATE_ENTRY * templateInfo, const UNSIGNED8 * column, UNSIGNED8 mask, UNSIGNED8 value, UNSIGNED16 * attrIds, UNSIGNED16 maxAttrIds, UNSIGNED16 * numAttrIds)
+{
+	TEMPLATE_ENTRY_EXT * entryExt = (TEMPLATE_ENTRY_EXT *)templateInfo;
+	UNSIGNED16 numProperties = entryExt->numProperties;
+	const UNSIGNED16 * columnAttrIds = entryExt->propertyAttrIds;
+	UNSIGNED16 count = 0;
+	UNSIGNED16 index;
+
+	if(maxAttrIds >= numProperties)
+	{
+		for(index = 0; index < numProperties; index++)
+		{
+			attrIds[count] = columnAttrIds[index];
+			count += ((column[index] & mask) == value);
+		}
+	}
+	else
+	{
+		for(index = 0; index < numProperties; index++)
+		{
+			if((column[index] & mask) != value)
+				continue;
+
+			if(count < maxAttrIds)
+				attrIds[count] = columnAttrIds[index];
+			count++;
+		}
+	}
+
+	*numAttrIds = count;
+	return (count > maxAttrIds) ? ERROR_RESPONSE : OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplatePropertiesByFlags method
+
+Purpose:  This is a public accessible method, returns the attribute Ids of the template
+properties matching a combination of TEMPLATE_PROPERTY_FLAG_xxx flags, e.g. all the
+writable properties: flagMask = flagValue = TEMPLATE_PROPERTY_FLAG_WRITABLE.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+from hash
+		  Flags to test and the value they must have
+		  Output array and its size
+
+Outputs:  Attribute Ids of the matching properties in attribute Id order, and their count.
+ERROR_RESPONSE if the array is too small, the count then tells the size needed.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplatePropertiesByFlags(UNSIGNED16 templateId, UNSIGNED8 flagMask, UNSIGNED8 flagValue, UNSIGNED16 * attrIds, UNSIGNED16 maxAttrIds, UNSIGNED16 * numAttrIds)
+{
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
+
+	if(!errorStatus)
+		return scanTemplatePropertyColumn(templateInfo, ((TEMPLATE_ENTRY_EXT *)templateInfo)->propertyFlags, flagMask, flagValue, attrIds, maxAttrIds, numAttrIds);
+
+	return errorStatus;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplatePropertiesByDataType method
+
+Purpose:  This is a public accessible method, returns the attribute Ids of the template
+properties of a given data type.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+from hash
+		  Data type
+		  Output array and its size
+
+Outputs:  Attribute Ids of the matching properties in attribute Id order, and their count.
+ERROR_RESPONSE if the array is too small, the count then tells the size needed.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplatePropertiesByDataType(UNSIGNED16 templateId, UNSIGNED8 dataType, UNSIGNED16 * attrIds, UNSIGNED16 maxAttrIds, UNSIGNED16 * numAttrIds)
+{
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
+
+	if(!errorStatus)
+		return scanTemplatePropertyColumn(templateInfo, ((TEMPLATE_ENTRY_EXT *)templateInfo)->propertyDataTypes, 0xFF, dataType, attrIds, maxAttrIds, numAttrIds);
+
+	return errorStatus;
+}
+
 /*------------------------------------------------------------------------------
 Module:   GetTemplateKeyPropertyAttributeId method
 
@@ -339,68 +702,81 @@ attribute Id list
 Inputs:   Template Id key from which the template Information needs to be retrieved
 from hash
 
-Outputs:  Pointer to Template's key property attributes list.
+Outputs:  Pointer to Template's key property attributes list (attribute Id order). The
+list is owned by the template database; it is read-only for the caller and must not be
+released.
 ------------------------------------------------------------------------------*/
 ERROR_STATUS  GetTemplateKeyPropertyAttributes (UNSIGNED16 templateId,TEMPLATE_PROPERTY_ATTR_INFOLIST** templateKeyPropertiesVal)
 {
-		TEMPLATE_ENTRY * templateInfo = NULL;
-		TEMPLATE_PROPERTY_ATTR_INFOLIST *templateKeyProperties;
-		TEMPLATE_PROPERTY_ATTR_INFO  *templateKeyProperty;
-		TEMPLATE_PROPERTY_ATTR_INFO  *templateKeyProperty1;
-		ERROR_STATUS errorStatus;
-		struct hashEntry_s *node;
-		APSHASHTBL *mainnodes;
-		UNSIGNED16 index=0;
-		UNSIGNED16 attIdCount=0;
-		UNSIGNED16 totalAttributesCounts=0;
-		void *data =NULL;
-
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	ERROR_STATUS errorStatus;
 
 	errorStatus = getTemplateInfo(templateId, &templateInfo);
-		if(!errorStatus)
-		{
-			mainnodes =templateInfo->templateAttrInfo;
-			for(index=0;index < 8 ; index++)
-			{
-				//Get the template present value attribute
-				node = mainnodes->nodes[index];
-				while(node)
-				{
-					//*data = node->data;
-					totalAttributesCounts = totalAttributesCounts +1;
-					node=node->next;
-				}
-			}
-			//Allocate memory for template Key Properties
-		templateKeyProperties = (TEMPLATE_PROPERTY_ATTR_INFOLIST *)OSacquire(sizeof(TEMPLATE_PROPERTY_ATTR_INFOLIST));
-			//Allocate memory for template Key Properties
-			templateKeyProperty = (TEMPLATE_PROPERTY_ATTR_INFO *)OSacquire(sizeof(TEMPLATE_PROPERTY_ATTR_INFO) * totalAttributesCounts);
-				mainnodes =templateInfo->templateAttrInfo;
-				for(index=0;index < 8 ; index++)
-				{
-					//Get the template present value attribute
-					node = mainnodes->nodes[index];
-					while(node)
-					{
-						data= (void **)node->data;
-						templateKeyProperty1=(TEMPLATE_PROPERTY_ATTR_INFO *)node->data;
-						templateKeyProperty[attIdCount]=*(TEMPLATE_PROPERTY_ATTR_INFO *)node->data;// *templateKeyProperty1;
-						attIdCount++;
-						node=node->next;
-					}
-				}
-				templateKeyProperties->numtemplatePropertyInfoEntries=totalAttributesCounts;
-				templateKeyProperties->propertyInfo=templateKeyProperty;
-				*templateKeyPropertiesVal=templateKeyProperties;
-			return OK;
+	if(!errorStatus)
+		errorStatus = getTemplatePropertyRecords((TEMPLATE_ENTRY_EXT *)templateInfo);
+
+	if(!errorStatus)
+		*templateKeyPropertiesVal = &((TEMPLATE_ENTRY_EXT *)templateInfo)->propertyList;
 
-		}
 	return errorStatus;
 	//No need for Release - 1
-//	return OK;
 }
 
+/*------------------------------------------------------------------------------
+Module:   GetTemplatePropertyListRef method
+
+Purpose:  This is a public accessible method, returns the template's property list,
+as GetTemplateKeyPropertyAttributes does, typed read-only.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+from hash
+
+Outputs:  Pointer to the template's property list (attribute Id order), owned by the
+template database. It is read-only for the caller and must not be released.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplatePropertyListRef(UNSIGNED16 templateId, const TEMPLATE_PROPERTY_ATTR_INFOLIST ** propertyList)
+{
+	TEMPLATE_PROPERTY_ATTR_INFOLIST * templateKeyProperties = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = GetTemplateKeyPropertyAttributes(templateId, &templateKeyProperties);
+	if(!errorStatus)
+		*propertyList = templateKeyProperties;
+
+	return errorStatus;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplatePropertyArray method
+
+Purpose:  This is a public accessible method, returns all the properties of a template
+without copying them. The array is sorted by attribute Id.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+from hash
+
+Outputs:  Pointer to the template's property array and its number of entries. The array
+is owned by the template database and must not be modified or released.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplatePropertyArray(UNSIGNED16 templateId, TEMPLATE_PROPERTY_ATTR_INFO ** propertyArray, UNSIGNED16 * numProperties)
+{
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
+
+	if(!errorStatus)
+		errorStatus = getTemplatePropertyRecords((TEMPLATE_ENTRY_EXT *)templateInfo);
+
+	if(!errorStatus)
+	{
+		*propertyArray = ((TEMPLATE_ENTRY_EXT *)templateInfo)->propertyList.propertyInfo;
+		*numProperties = ((TEMPLATE_ENTRY_EXT *)templateInfo)->propertyList.numtemplatePropertyInfoEntries;
+		return OK;
+	}
 
+	return errorStatus;
+}
 
 /*------------------------------------------------------------------------------
 Module:   GetTemplateKeyPropertyAttributeId method
@@ -554,66 +930,53 @@ ERROR_STATUS GetTemplateID (UNSIGNED16 templateId, TCHAR ** templateID)
 
 
 /*------------------------------------------------------------------------------
-Module:   GetTemplateSubComponent method
+Module:   GetTemplateSubComponentList method
 
-Purpose:  This is a public accessible method, returns the template subcomponent for a 
-given template Id and component Id. The caller must pass the component Id to be retrieved.
+Purpose:  This is a public accessible method, returns all the subcomponents of a
+given template Id in template file order.
 
 Inputs:   Template Id key from which the template Information needs to be retrieved
 			from hash
-		  Component Id that needs to be fetched from the template
 
-Outputs:  Pointer to Template Sub Component
+Outputs:  Pointer to Template Sub Component list, empty if the template has no
+subcomponents. The list is owned by the template database; it is read-only for the
+caller and must not be released.
 ------------------------------------------------------------------------------*/
 ERROR_STATUS  GetTemplateSubComponentList(UNSIGNED16 templateId, TEMPLATE_SUBCOMPONENT_INFO_LIST** templateSubComponentInfo)
 {
 	TEMPLATE_ENTRY * templateInfo = NULL;
 	ERROR_STATUS errorStatus;
-	APSHASHTBL *mainnodes = NULL;
-	struct hashEntry_s *node = NULL;
-	TEMPLATE_SUBCOMPONENT_INFO_LIST* subComponentInfoList = NULL;
-	TEMPLATE_SUBCOMPONENT_INFO* subComponentProperties  = NULL;
-	UNSIGNED16 totalSubComponentCount = 0;
-	void *data = NULL;
-	errorStatus = getTemplateInfo(templateId, &templateInfo);
-	
 
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
 	if(!errorStatus)
-	{
+		*templateSubComponentInfo = &((TEMPLATE_ENTRY_EXT *)templateInfo)->subComponentList;
 
-		//Get the template subcomponent
-		if(templateInfo->templateSubComponentInfo == NULL)
-			return TEMPLATE_SUBCOMPONENT_NOT_FOUND;
-		mainnodes = (APSHASHTBL* )templateInfo->templateSubComponentInfo;
-		node = mainnodes->nodes[0];
-		while(node)
-		{
-			totalSubComponentCount = totalSubComponentCount + 1;
-			node=node->next;
-		}
-		subComponentInfoList = (TEMPLATE_SUBCOMPONENT_INFO_LIST *)OSacquire(sizeof(TEMPLATE_SUBCOMPONENT_INFO_LIST));
-		//mainnodes = (APSHASHTBL* )templateInfo->templateSubComponentInfo;
-		subComponentProperties = (TEMPLATE_SUBCOMPONENT_INFO *)OSacquire(sizeof(TEMPLATE_SUBCOMPONENT_INFO) * totalSubComponentCount);
-		node = mainnodes->nodes[0];
-		if(!(subComponentInfoList && mainnodes && subComponentProperties && node))
-			return TEMPLATE_PARSE_ERROR;
-		totalSubComponentCount = 0;
-		while(node)
-		{
-			data = (void **)node->data;
-			subComponentProperties[totalSubComponentCount] = *(TEMPLATE_SUBCOMPONENT_INFO *)node->data;// *templateKeyProperty1;
-			totalSubComponentCount = totalSubComponentCount + 1;
-			node=node->next;
-		}
-		subComponentInfoList->numSubComponentInfoEntries = totalSubComponentCount;
-		subComponentInfoList->subComponentInfo = subComponentProperties;
-		*templateSubComponentInfo = subComponentInfoList;
-		//else
-		//	templateSubComponentInfo = templateInfo->templateSubComponentInfo
+	return errorStatus;
+	//No need for Release - 1
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplateSubComponentListRef method
+
+Purpose:  This is a public accessible method, returns the subcomponents of a given
+template Id, as GetTemplateSubComponentList does, typed read-only.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+			from hash
+
+Outputs:  Pointer to Template Sub Component list in template file order, empty if the
+template has no subcomponents. The list is owned by the template database; it is
+read-only for the caller and must not be released.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplateSubComponentListRef(UNSIGNED16 templateId, const TEMPLATE_SUBCOMPONENT_INFO_LIST ** subComponentList)
+{
+	TEMPLATE_SUBCOMPONENT_INFO_LIST * templateSubComponentInfo = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = GetTemplateSubComponentList(templateId, &templateSubComponentInfo);
+	if(!errorStatus)
+		*subComponentList = templateSubComponentInfo;
 
-		return OK;
-	}
-	
 	return errorStatus;
 }
 
@@ -0,0 +1,216 @@
+/*------------------------------------------------------------------------------
+
+Module:   Template Reverse Index
+
+Purpose:  Maintains the reverse indexes of the template database: attribute Id to the
+          templates declaring it, and subcomponent template Id to the templates that
+          embed it. Every template is indexed once when it is added to the database,
+          so the queries cost the size of their result instead of a walk over every
+          template and its attribute hash.
+
+Filename: template_index.c
+
+Inputs:   Template database the templates are added to
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+#include <template_api.h>
+#include "template_api_private.h"
+
+/*------------------------------------------------------------------------------
+Module:   addPosting method
+
+Purpose:  Appends a template Id to the posting list stored under a key, creating the
+          list on first use. A template adding the same key twice (e.g. two
+          subcomponents of the same template) is listed once.
+
+Inputs:   indexHash - Reverse index hash
+          key, keyLen - Key of the posting list
+          templateId - Template Id to append
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+static ERROR_STATUS addPosting(APSHASHTBL * indexHash, void * key, UNSIGNED16 keyLen, UNSIGNED16 templateId)
+{
+	TEMPLATE_POSTING_LIST * postingList = NULL;
+	UNSIGNED16 * templateIds;
+	ERROR_STATUS status;
+
+	if(hashtbl_get(indexHash, key, keyLen, (void **)&postingList))
+	{
+		postingList = (TEMPLATE_POSTING_LIST *)OSacquire(sizeof(TEMPLATE_POSTING_LIST));
+		if(postingList == NULL)
+			return NOT_ENOUGH_MEMORY;
+
+		OSmemset(postingList, 0, sizeof(TEMPLATE_POSTING_LIST));
+
+		status = hashtbl_insert(indexHash, key, postingList, keyLen);
+		if(status != OK)
+		{
+			OSrelease(postingList);
+			return status;
+		}
+	}
+
+	//Templates are indexed one at a time, a repeat can only be the last entry
+	if(postingList->numTemplateIds > 0 && postingList->templateIds[postingList->numTemplateIds - 1] == templateId)
+		return OK;
+
+	if(postingList->numTemplateIds == postingList->maxTemplateIds)
+	{
+		templateIds = (UNSIGNED16 *)OSacquire(sizeof(UNSIGNED16) * (postingList->maxTemplateIds + TEMPLATE_POSTING_LIST_GROW_SIZE));
+		if(templateIds == NULL)
+			return NOT_ENOUGH_MEMORY;
+
+		if(postingList->templateIds != NULL)
+		{
+			OSmemcpy(templateIds, postingList->templateIds, sizeof(UNSIGNED16) * postingList->numTemplateIds);
+			OSrelease(postingList->templateIds);
+		}
+
+		postingList->templateIds = templateIds;
+		postingList->maxTemplateIds += TEMPLATE_POSTING_LIST_GROW_SIZE;
+	}
+
+	postingList->templateIds[postingList->numTemplateIds++] = templateId;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   IndexTemplateReferences method
+
+Purpose:  Adds a template just added to the database to the reverse indexes: its own
+          (declared, not inherited) attributes, the template Ids of its subcomponents
+          and the template it extends. The index hashes are created on first use.
+
+Inputs:   templateDb - Template database (allocated as TEMPLATE_DATABASE_EXT)
+          templateId - Template Id (key in templateStructureHash)
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS IndexTemplateReferences(TEMPLATE_DATABASE * templateDb, UNSIGNED16 templateId)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = (TEMPLATE_DATABASE_EXT *)templateDb;
+	TEMPLATE_ENTRY_EXT * entryExt = NULL;
+	TEMPLATE_SUBCOMPONENT_INFO * subcomponentInfo;
+	UNSIGNED16 index;
+	ERROR_STATUS status = OK;
+
+	if(templateDbExt == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	if(hashtbl_get(templateDb->templateStructureHash, &templateId, sizeof(templateId), (void **)&entryExt))
+		return TEMPLATE_NOT_FOUND;
+
+	if(templateDbExt->propertyTemplatesHash == NULL)
+	{
+		if((templateDbExt->propertyTemplatesHash = hashtbl_create(TEMPLATE_REVERSE_INDEX_GROW_SIZE, HASH_TYPE_INT)) == NULL)
+			return HASH_CREATE_ERROR;
+	}
+
+	if(templateDbExt->subComponentParentsHash == NULL)
+	{
+		if((templateDbExt->subComponentParentsHash = hashtbl_create(TEMPLATE_REVERSE_INDEX_GROW_SIZE, HASH_TYPE_STR)) == NULL)
+			return HASH_CREATE_ERROR;
+	}
+
+	if(templateDbExt->extendingTemplatesHash == NULL)
+	{
+		if((templateDbExt->extendingTemplatesHash = hashtbl_create(TEMPLATE_REVERSE_INDEX_GROW_SIZE, HASH_TYPE_STR)) == NULL)
+			return HASH_CREATE_ERROR;
+	}
+
+	for(index = 0; index < entryExt->numProperties && status == OK; index++)
+		status = addPosting(templateDbExt->propertyTemplatesHash, &entryExt->propertyAttrIds[index], sizeof(UNSIGNED16), templateId);
+
+	for(index = 0; index < entryExt->subComponentList.numSubComponentInfoEntries && status == OK; index++)
+	{
+		subcomponentInfo = &entryExt->subComponentList.subComponentInfo[index];
+
+		if(subcomponentInfo->templateId != NULL)
+			status = addPosting(templateDbExt->subComponentParentsHash, subcomponentInfo->templateId, STR_STORE(OSstrlen(subcomponentInfo->templateId)), templateId);
+	}
+
+	//Keyed by name, the parent may only be added later
+	if(status == OK && entryExt->entry.templateParent != NULL)
+		status = addPosting(templateDbExt->extendingTemplatesHash, entryExt->entry.templateParent, STR_STORE(OSstrlen(entryExt->entry.templateParent)), templateId);
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getPostingList method
+
+Purpose:  This is a private method and used internally. Looks up a posting list of one
+          of the reverse indexes of the current template database.
+
+Inputs:   propertyIndex - TRUE for the attribute index, FALSE for the subcomponent index
+          key, keyLen - Key of the posting list
+
+Outputs:  Template Ids, owned by the template database. No need for release.
+------------------------------------------------------------------------------*/
+static ERROR_STATUS getPostingList(UNSIGNED8 propertyIndex, void * key, UNSIGNED16 keyLen, const UNSIGNED16 ** templateIds, UNSIGNED16 * numTemplateIds)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = NULL;
+	TEMPLATE_POSTING_LIST * postingList = NULL;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+	APSHASHTBL * indexHash;
+
+	*templateIds = NULL;
+	*numTemplateIds = 0;
+
+	// get ptr to the model's class vars
+	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+	templateDbExt = (TEMPLATE_DATABASE_EXT *)classVarPtr->template_database;
+	if(templateDbExt == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	indexHash = propertyIndex ? templateDbExt->propertyTemplatesHash : templateDbExt->subComponentParentsHash;
+
+	if(indexHash == NULL || hashtbl_get(indexHash, key, keyLen, (void **)&postingList) || postingList == NULL)
+		return propertyIndex ? TEMPLATE_PROPERTY_NOT_FOUND : TEMPLATE_SUBCOMPONENT_NOT_FOUND;
+
+	*templateIds = postingList->templateIds;
+	*numTemplateIds = postingList->numTemplateIds;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplatesByProperty method
+
+Purpose:  This is a public accessible method, returns the templates declaring an
+          attribute.
+
+Inputs:   attrId - Property Attribute ID
+
+Outputs:  Template Ids in the order the templates were added, owned by the template
+          database. No need for release.
+          TEMPLATE_PROPERTY_NOT_FOUND if no template declares the attribute.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplatesByProperty(UNSIGNED16 attrId, const UNSIGNED16 ** templateIds, UNSIGNED16 * numTemplateIds)
+{
+	return getPostingList(TRUE, &attrId, sizeof(attrId), templateIds, numTemplateIds);
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplatesBySubComponentTemplate method
+
+Purpose:  This is a public accessible method, returns the templates embedding a given
+          template as a subcomponent.
+
+Inputs:   subComponentTemplateId - Template Id of the subcomponent ("templateId" value)
+
+Outputs:  Template Ids in the order the templates were added, owned by the template
+          database. No need for release.
+          TEMPLATE_SUBCOMPONENT_NOT_FOUND if no template embeds it.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplatesBySubComponentTemplate(TCHAR * subComponentTemplateId, const UNSIGNED16 ** templateIds, UNSIGNED16 * numTemplateIds)
+{
+	if(subComponentTemplateId == NULL)
+		return TEMPLATE_SUBCOMPONENT_NOT_FOUND;
+
+	return getPostingList(FALSE, subComponentTemplateId, STR_STORE(OSstrlen(subComponentTemplateId)), templateIds, numTemplateIds);
+}
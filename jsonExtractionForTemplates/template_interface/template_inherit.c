@@ -0,0 +1,343 @@
+/*------------------------------------------------------------------------------
+
+Module:   Template Inheritance
+
+Purpose:  Resolves the "-extends" hierarchy of the templates in the database. Every
+          template gets its flattened property and subcomponent set (own entries
+          plus the inherited ones it does not override) computed once, so consumers
+          do not have to walk the parent chain through name lookups on every query.
+
+Filename: template_inherit.c
+
+Inputs:   Template database after templates were added to it
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+#include <template_api.h>
+#include "template_api_private.h"
+
+/*------------------------------------------------------------------------------
+Module:   releaseResolvedInfo method
+
+Purpose:  Drops the resolved content of a template and marks it unresolved. The
+          arrays are kept, the next resolution rebuilds them in place.
+
+Inputs:   entryExt - Template entry
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void releaseResolvedInfo(TEMPLATE_ENTRY_EXT * entryExt)
+{
+	TEMPLATE_PROPERTY_REF * propertyInfo = entryExt->resolvedInfo.propertyInfo;
+	TEMPLATE_SUBCOMPONENT_INFO ** subComponentInfo = entryExt->resolvedInfo.subComponentInfo;
+
+	OSmemset(&entryExt->resolvedInfo, 0, sizeof(entryExt->resolvedInfo));
+	entryExt->resolvedInfo.propertyInfo = propertyInfo;
+	entryExt->resolvedInfo.subComponentInfo = subComponentInfo;
+	entryExt->resolveState = TEMPLATE_UNRESOLVED;
+}
+
+/*------------------------------------------------------------------------------
+Module:   reserveResolvedArray method
+
+Purpose:  Makes sure a resolved array has room for count entries. The array is
+          reused when it is large enough, else it is replaced by a larger one and
+          the old one released.
+
+Inputs:   resolvedArray - Array to reserve, NULL if none yet
+          maxEntries - Room in the array
+          count - Entries needed
+          entrySize - Size of one entry
+
+Outputs:  resolvedArray, maxEntries - Updated
+          OK, NOT_ENOUGH_MEMORY (the array is left as it was)
+------------------------------------------------------------------------------*/
+static ERROR_STATUS reserveResolvedArray(void ** resolvedArray, UNSIGNED16 * maxEntries, UNSIGNED32 count, UNSIGNED32 entrySize)
+{
+	void * newArray;
+
+	if(count <= *maxEntries)
+		return OK;
+
+	newArray = OSacquire(entrySize * count);
+	if(newArray == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	if(*resolvedArray != NULL)
+		OSrelease(*resolvedArray);
+
+	*resolvedArray = newArray;
+	*maxEntries = (UNSIGNED16)count;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   resolveTemplate method
+
+Purpose:  Resolves one template, resolving its parent chain first (depth first).
+          A parent still being resolved means the "-extends" chain is cyclic; the
+          link closing the cycle is ignored and TEMPLATE_PARSE_ERROR is reported,
+          the templates involved are still resolved.
+
+Inputs:   templateDb - Template database
+          entryExt - Template entry to resolve
+
+Outputs:  OK, TEMPLATE_PARSE_ERROR on a cycle, NOT_ENOUGH_MEMORY
+------------------------------------------------------------------------------*/
+static ERROR_STATUS resolveTemplate(TEMPLATE_DATABASE * templateDb, TEMPLATE_ENTRY_EXT * entryExt)
+{
+	TEMPLATE_ENTRY * templateEntry = &entryExt->entry;
+	TEMPLATE_RESOLVED_INFO * resolvedInfo = &entryExt->resolvedInfo;
+	TEMPLATE_RESOLVED_INFO * parentInfo = NULL;
+	TEMPLATE_ENTRY_EXT * parentExt = NULL;
+	TEMPLATE_PROPERTY_REF propertyRef;
+	TEMPLATE_SUBCOMPONENT_INFO * subcomponentInfo;
+	UNSIGNED16 * parentNumber = NULL;
+	UNSIGNED32 total, count, index;
+	void * data;
+	ERROR_STATUS status = OK;
+
+	if(entryExt->resolveState == TEMPLATE_RESOLVED)
+		return OK;
+
+	entryExt->resolveState = TEMPLATE_RESOLVING;
+
+	//Parent is looked up by its template ID, the key of the template hash
+	if(templateEntry->templateParent != NULL &&
+		!hashtbl_get(templateDb->templateHash, templateEntry->templateParent, STR_STORE(OSstrlen(templateEntry->templateParent)), (void **)&parentNumber) &&
+		!hashtbl_get(templateDb->templateStructureHash, parentNumber, sizeof(*parentNumber), (void **)&parentExt) &&
+		parentExt != NULL)
+	{
+		if(parentExt->resolveState == TEMPLATE_RESOLVING)
+		{
+			status = TEMPLATE_PARSE_ERROR;
+		}
+		else
+		{
+			status = resolveTemplate(templateDb, parentExt);
+			if(status == NOT_ENOUGH_MEMORY)
+			{
+				entryExt->resolveState = TEMPLATE_UNRESOLVED;
+				return status;
+			}
+
+			parentInfo = &parentExt->resolvedInfo;
+			resolvedInfo->parentTemplateId = *parentNumber;
+			resolvedInfo->inheritanceDepth = parentInfo->inheritanceDepth + 1;
+		}
+	}
+
+	//Properties - own ones, then inherited ones not overridden by attribute Id
+	total = entryExt->numProperties;
+	if(parentInfo != NULL)
+		total += parentInfo->numPropertyEntries;
+
+	if(total > 0)
+	{
+		if(reserveResolvedArray((void **)&resolvedInfo->propertyInfo, &entryExt->maxResolvedProperties, total, sizeof(TEMPLATE_PROPERTY_REF)) != OK)
+		{
+			releaseResolvedInfo(entryExt);
+			return NOT_ENOUGH_MEMORY;
+		}
+
+		count = 0;
+		for(index = 0; index < entryExt->numProperties; index++)
+		{
+			resolvedInfo->propertyInfo[count].owner = entryExt;
+			resolvedInfo->propertyInfo[count++].index = (UNSIGNED16)index;
+		}
+
+		for(index = 0; parentInfo != NULL && index < parentInfo->numPropertyEntries; index++)
+		{
+			propertyRef = parentInfo->propertyInfo[index];
+			if(findTemplatePropertyIndex(entryExt, propertyRef.owner->propertyAttrIds[propertyRef.index]) < 0)
+				resolvedInfo->propertyInfo[count++] = propertyRef;
+		}
+
+		resolvedInfo->numPropertyEntries = (UNSIGNED16)count;
+	}
+
+	//Subcomponents - own ones, then inherited ones not overridden by subcomponent Id
+	total = entryExt->subComponentList.numSubComponentInfoEntries;
+	if(parentInfo != NULL)
+		total += parentInfo->numSubComponentEntries;
+
+	if(total > 0)
+	{
+		if(reserveResolvedArray((void **)&resolvedInfo->subComponentInfo, &entryExt->maxResolvedSubComponents, total, sizeof(TEMPLATE_SUBCOMPONENT_INFO *)) != OK)
+		{
+			releaseResolvedInfo(entryExt);
+			return NOT_ENOUGH_MEMORY;
+		}
+
+		count = 0;
+		for(index = 0; index < entryExt->subComponentList.numSubComponentInfoEntries; index++)
+			resolvedInfo->subComponentInfo[count++] = &entryExt->subComponentList.subComponentInfo[index];
+
+		for(index = 0; parentInfo != NULL && index < parentInfo->numSubComponentEntries; index++)
+		{
+			subcomponentInfo = parentInfo->subComponentInfo[index];
+			if(templateEntry->templateSubComponentInfo == NULL ||
+				hashtbl_get(templateEntry->templateSubComponentInfo, subcomponentInfo->subComponentId, STR_STORE(OSstrlen(subcomponentInfo->subComponentId)), &data))
+				resolvedInfo->subComponentInfo[count++] = subcomponentInfo;
+		}
+
+		resolvedInfo->numSubComponentEntries = (UNSIGNED16)count;
+	}
+
+	entryExt->resolveState = TEMPLATE_RESOLVED;
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   ResolveTemplateInheritance method
+
+Purpose:  Post-load pass over the template database. Drops any previous resolution
+          and resolves every template. Templates added to a resolved database later
+          on go through ResolveAddedTemplate instead.
+
+Inputs:   templateDb - Template database
+
+Outputs:  OK, TEMPLATE_PARSE_ERROR if the hierarchy has a cycle (all templates are
+          still resolved), NOT_ENOUGH_MEMORY
+------------------------------------------------------------------------------*/
+ERROR_STATUS ResolveTemplateInheritance(TEMPLATE_DATABASE * templateDb)
+{
+	APSHASHTBL * structureHash;
+	struct hashEntry_s * node;
+	hashIndex idx;
+	ERROR_STATUS result;
+	ERROR_STATUS status = OK;
+
+	if(templateDb == NULL || templateDb->templateStructureHash == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	structureHash = templateDb->templateStructureHash;
+
+	for(idx = 0; idx < structureHash->size; idx++)
+		for(node = structureHash->nodes[idx]; node != NULL; node = node->next)
+			releaseResolvedInfo((TEMPLATE_ENTRY_EXT *)node->data);
+
+	for(idx = 0; idx < structureHash->size; idx++)
+	{
+		for(node = structureHash->nodes[idx]; node != NULL; node = node->next)
+		{
+			result = resolveTemplate(templateDb, (TEMPLATE_ENTRY_EXT *)node->data);
+			if(result == NOT_ENOUGH_MEMORY)
+				return result;
+
+			if(result != OK)
+				status = result;
+		}
+	}
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   unresolveExtendingTemplates method
+
+Purpose:  Drops the resolution of every template extending the named template,
+          directly or through other templates, so they pick up a newly added
+          ancestor. Templates already unresolved are not walked again, which also
+          ends the walk on a cyclic "-extends" chain.
+
+Inputs:   templateDb - Template database
+          templateId - Template ID ("-ID" value) of the added template
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void unresolveExtendingTemplates(TEMPLATE_DATABASE * templateDb, TCHAR * templateId)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = (TEMPLATE_DATABASE_EXT *)templateDb;
+	TEMPLATE_POSTING_LIST * postingList = NULL;
+	TEMPLATE_ENTRY_EXT * childExt = NULL;
+	UNSIGNED16 index;
+
+	if(templateId == NULL || templateDbExt->extendingTemplatesHash == NULL ||
+		hashtbl_get(templateDbExt->extendingTemplatesHash, templateId, STR_STORE(OSstrlen(templateId)), (void **)&postingList))
+		return;
+
+	for(index = 0; index < postingList->numTemplateIds; index++)
+	{
+		if(hashtbl_get(templateDb->templateStructureHash, &postingList->templateIds[index], sizeof(UNSIGNED16), (void **)&childExt) ||
+			childExt->resolveState == TEMPLATE_UNRESOLVED)
+			continue;
+
+		releaseResolvedInfo(childExt);
+		unresolveExtendingTemplates(templateDb, childExt->entry.templateID);
+	}
+}
+
+/*------------------------------------------------------------------------------
+Module:   ResolveAddedTemplate method
+
+Purpose:  Resolves a template just added to a resolved database. Only the new
+          template and the templates extending it change; the extending ones are
+          dropped here and resolved again on demand by GetTemplateResolvedInfo.
+
+Inputs:   templateDb - Template database
+          templateId - Template Id (key in templateStructureHash) of the added template
+
+Outputs:  OK, TEMPLATE_PARSE_ERROR if the hierarchy has a cycle, NOT_ENOUGH_MEMORY
+------------------------------------------------------------------------------*/
+ERROR_STATUS ResolveAddedTemplate(TEMPLATE_DATABASE * templateDb, UNSIGNED16 templateId)
+{
+	TEMPLATE_ENTRY_EXT * entryExt = NULL;
+
+	if(templateDb == NULL || templateDb->templateStructureHash == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	if(hashtbl_get(templateDb->templateStructureHash, &templateId, sizeof(templateId), (void **)&entryExt))
+		return TEMPLATE_NOT_FOUND;
+
+	unresolveExtendingTemplates(templateDb, entryExt->entry.templateID);
+
+	return resolveTemplate(templateDb, entryExt);
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplateResolvedInfo method
+
+Purpose:  This is a public accessible method, returns the effective (inheritance
+          resolved) properties and subcomponents of a template. A template added
+          since the last resolution pass is resolved on demand.
+
+Inputs:   Template Id key from which the template Information needs to be retrieved
+from hash
+
+Outputs:  Pointer to the resolved info, owned by the template database. No need for
+          release. The info is updated in place when the template is resolved again,
+          the arrays it points to are only valid until the next template is added.
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplateResolvedInfo(UNSIGNED16 templateId, TEMPLATE_RESOLVED_INFO ** resolvedInfo)
+{
+	TEMPLATE_ENTRY * templateInfo = NULL;
+	TEMPLATE_ENTRY_EXT * entryExt;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+	ERROR_STATUS errorStatus;
+
+	errorStatus = getTemplateInfo(templateId, &templateInfo);
+
+	if(!errorStatus)
+	{
+		entryExt = (TEMPLATE_ENTRY_EXT *)templateInfo;
+
+		if(entryExt->resolveState != TEMPLATE_RESOLVED)
+		{
+			// get ptr to the model's class vars
+			classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+			errorStatus = resolveTemplate(classVarPtr->template_database, entryExt);
+			if(errorStatus == NOT_ENOUGH_MEMORY)
+				return errorStatus;
+		}
+
+		*resolvedInfo = &entryExt->resolvedInfo;
+		return OK;
+	}
+
+	return errorStatus;
+}
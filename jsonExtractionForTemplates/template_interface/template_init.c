@@ -42,6 +42,9 @@ ERROR_STATUS InitTemplate()
 	UNSIGNED16 * unicodeTemplateName = NULL;
 	UNSIGNED16 * unicodeTemplateVersion = NULL;
 	MODEL_CLASS_VARS *classVarPtr = NULL;
+	TCHAR * jsonFilePath = NULL;
+	UNSIGNED32 sourceCrc = 0, sourceSize = 0;
+	UNSIGNED8 snapshotKeyValid = FALSE;
 	
 	// get ptr to the model's class vars
   if(equipmentModelClassIndex == 0)
@@ -52,9 +55,10 @@ ERROR_STATUS InitTemplate()
   classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
 
 	//Allocate memory for Template
-	tempDb = (TEMPLATE_DATABASE *)OSacquire(sizeof(TEMPLATE_DATABASE));
+	tempDb = (TEMPLATE_DATABASE *)OSacquire(sizeof(TEMPLATE_DATABASE_EXT));
 	if(tempDb == NULL)
 		return NOT_ENOUGH_MEMORY;
+	OSmemset(tempDb, 0, sizeof(TEMPLATE_DATABASE_EXT));
 	
 	//Hash list to store the template name and its corresponding Id.
 	if((templateHash=hashtbl_create(TEMPLATE_DB_ENTRY_GROW_SIZE, HASH_TYPE_STR)) == NULL) 
@@ -68,8 +72,39 @@ ERROR_STATUS InitTemplate()
 	tempDb->templateHash = templateHash;
 	tempDb->templateStructureHash = templateReferenceHash;
 
-	//Read the big template File
-	status = ReadTemplateFile(NULL, &buffer,FALSE);
+	//Locate the big template File
+	status = GetTemplateFilePath(NULL, &jsonFilePath, FALSE);
+	if(!status)
+	{
+		//Warm start - if the template file did not change since the last snapshot,
+		//restore the built database from it instead of parsing the template file.
+		if(GetTemplateFileCrc(jsonFilePath, &sourceCrc, &sourceSize) == OK)
+		{
+			status = RestoreTemplateSnapshot(jsonFilePath, sourceCrc, sourceSize, tempDb, (TCHAR **)&unicodeTemplateVersion);
+			if(status == OK)
+			{
+				OSrelease(jsonFilePath);
+				ResolveTemplateInheritance(tempDb);
+				classVarPtr->template_Version = (TCHAR *)unicodeTemplateVersion;
+				if(classVarPtr->template_database != NULL)
+					ReleaseTemplateExportCache(classVarPtr->template_database);
+				classVarPtr->template_database = tempDb;
+				return OK;
+			}
+			else if(status == NOT_ENOUGH_MEMORY || status == HASH_CREATE_ERROR)
+			{
+				OSrelease(jsonFilePath);
+				return status;
+			}
+
+			//Any other failure left the database empty, parse the template file into it
+			snapshotKeyValid = TRUE;
+		}
+
+		//Read the big template File
+		status = ReadTemplateFileFromPath(jsonFilePath, &buffer);
+	}
+
 	if(!status)
 	{
 		//Status is Ok..We should be able to pass this data to json interface.
@@ -127,12 +162,18 @@ ERROR_STATUS InitTemplate()
 
       //Clear the json Object
       json_decref(jsonObject);
+
+			//Dump the built database so the next start can skip parsing
+			if(snapshotKeyValid)
+				SaveTemplateSnapshot(jsonFilePath, sourceCrc, sourceSize, tempDb, classVarPtr->template_Version);
 		}
 		
 	}
 	else if(status == NOT_ENOUGH_MEMORY)
 	{
 		//OSTrace(_T("Not enough memory to perform this operation.."));
+		if(jsonFilePath != NULL)
+			OSrelease(jsonFilePath);
 		return status;
 	}
 	else
@@ -140,8 +181,19 @@ ERROR_STATUS InitTemplate()
 		//OSTrace(_T("Resource did not exist, we might get single template loaded"));
 	}
 	
+	if(jsonFilePath != NULL)
+		OSrelease(jsonFilePath);
 
+	//Flatten the "-extends" hierarchy once so the getters don't walk the parent chain
+	if(ResolveTemplateInheritance(tempDb) == TEMPLATE_PARSE_ERROR)
+	{
+		//OSTrace(_T("Cyclic template inheritance, the link closing the cycle is ignored.."));
+	}
 	
+	//A database replaced by this one gives up its cached export
+	if(classVarPtr->template_database != NULL)
+		ReleaseTemplateExportCache(classVarPtr->template_database);
+
 	classVarPtr->template_database = tempDb;
 
 	return OK;
@@ -244,7 +296,9 @@ json_t *jsonObject, *jsonTemplateArray, *jsonTemplateData;
 
 						if(hashtbl_get(templateDb->templateHash, (TCHAR *)unicodeTemplateTempName, STR_STORE(OSstrlen((TCHAR *)unicodeTemplateTempName)), (void **)&tempStorage))		
 							{
-								AddTemplateToHash((TCHAR *)unicodeTemplateTempName, jsonTemplateData, templateDb);
+								//The new template may extend or be extended by loaded ones
+								if(AddTemplateToHash((TCHAR *)unicodeTemplateTempName, jsonTemplateData, templateDb) == OK)
+									ResolveAddedTemplate(templateDb, templateDb->templateCount);
 								//*templateId = templateDb->templateCount;
 							}
 
@@ -366,7 +420,9 @@ json_t *jsonObject, *jsonTemplateArray, *jsonTemplateData;
 						ret = OSstrcmp((TCHAR *)unicodeTemplateName,interfaceName);
 							if(ret == 0)
 							{
-								AddTemplateToHash((TCHAR *)unicodeTemplateName, jsonTemplateData, templateDb);
+								//The new template may extend or be extended by loaded ones
+								if(AddTemplateToHash((TCHAR *)unicodeTemplateName, jsonTemplateData, templateDb) == OK)
+									ResolveAddedTemplate(templateDb, templateDb->templateCount);
 								*templateId = templateDb->templateCount;
 							}
 
@@ -394,317 +450,36 @@ json_t *jsonObject, *jsonTemplateArray, *jsonTemplateData;
 
 
 
-ERROR_STATUS CreateNewTemplate(char ** newTemplate){
-	
-	TEMPLATE_DATABASE * templateDb = NULL;
-	MODEL_CLASS_VARS *classVarPtr = NULL;
-
-
-	UNSIGNED16 * unicodeTemplateData = NULL;
-	UNSIGNED16 templateData = 0;
-	TCHAR* templateCharData = NULL;
-	UNSIGNED16 templateCountID = 0;
-	void * dataTemplateNode = NULL;
-	UNSIGNED16  templateCount, temp=0;
-	SIGNED8 * asciitemplateData = NULL;
-	
-	
-	json_t *root = json_object();
-	json_t *rootTemplateElement = NULL;
-	json_t *json_arr = json_array();
-
-	APSHASHTBL *templateHashNodes = NULL;
-	struct hashEntry_s *templateNode;
-	char* s = NULL;
-
-	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
-	templateDb = classVarPtr->template_database;
-
-	//getTemplate Version and adding it to jason structure.
-	unicodeTemplateData = (UNSIGNED16 *)classVarPtr->template_Version;
-	if(unicodeTemplateData){
-		if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-			if(asciitemplateData){
-				json_object_set_new( root, "Version", json_string(asciitemplateData ) );
-				asciitemplateData = NULL;
-			}
-			unicodeTemplateData = NULL;
-		}
-	}
-
+/*------------------------------------------------------------------------------
+Module:   CreateNewTemplate method
 
-	json_object_set_new( root, "Template", json_arr );
+Purpose:  Serializes the template database into one template JSON string. The
+		  document is written for this call only, the database keeps no copy (callers
+		  wanting a shared, cached document use GetTemplateExport).
 
-	templateCount = templateDb->templateCount;
-	templateHashNodes = templateDb->templateHash;
-	templateNode = templateHashNodes->nodes[0];
+Inputs:   None
 
-	while(templateNode){
-		TEMPLATE_PROPERTY_ATTR_INFOLIST *propertyAttributeInfoList = NULL;
-		//TEMPLATE_PROPERTY_ATTR_INFO  propertyAttributeInfo;
-		TEMPLATE_SUBCOMPONENT_INFO_LIST* templateSubComponentInfoList = NULL;
-		//TEMPLATE_SUBCOMPONENT_INFO templateSubComponentInfo;
-		
-		rootTemplateElement = json_object();
-		templateCountID =  *(UNSIGNED16*)(void **)templateNode->data;
-	//	GetTemplatePropertyInfo(templateCountID,7011,0,&attrinfo);
-		
-		if(!GetTemplateType(templateCountID, &templateData)){
-			if(!getAsciiFromUnicode(&templateData, &asciitemplateData)){
-				if(asciitemplateData){
-					json_object_set_new( rootTemplateElement, "-type", json_integer( *asciitemplateData ) );
-					asciitemplateData = NULL;
-				}
-				templateData = 0;
-			}
-		}
-		if(!GetTemplateSubType(templateCountID, &templateData)){
-			if(!getAsciiFromUnicode(&templateData, &asciitemplateData)){
-				if(asciitemplateData){
-					json_object_set_new( rootTemplateElement, "-subtype", json_integer( *asciitemplateData ) );
-					asciitemplateData = NULL;
-				}
-				templateData = 0;
-			}
-		}
-		if(!GetTemplateParent(templateCountID, &templateCharData)){
-			unicodeTemplateData = (UNSIGNED16*)templateCharData;
-			if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-				if(asciitemplateData){
-					json_object_set_new( rootTemplateElement, "-extends", json_string( asciitemplateData ) );
-					asciitemplateData = NULL;
-				}
-				unicodeTemplateData = NULL;
-			}
-		}
-		if(!GetTemplateDescription(templateCountID, &templateCharData)){
-			unicodeTemplateData = (UNSIGNED16*)templateCharData;
-			if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-				if(asciitemplateData){
-					json_object_set_new( rootTemplateElement, "-description", json_string( asciitemplateData ) );
-					asciitemplateData = NULL;
-				}
-				unicodeTemplateData = NULL;
-			}
-		}
-		if(!GetDictionaryName(templateCountID, &templateCharData)){
-			unicodeTemplateData = (UNSIGNED16*)templateCharData;
-			if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-				if(asciitemplateData){
-					json_object_set_new( rootTemplateElement, "-dictionary", json_string( asciitemplateData ) );
-					asciitemplateData = NULL;
-				}
-				unicodeTemplateData = NULL;
-			}
-		}
-		if(!GetTemplateID(templateCountID, &templateCharData)){
-			unicodeTemplateData = (UNSIGNED16*)templateCharData;
-			if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-				if(asciitemplateData){
-					json_object_set_new( rootTemplateElement, "-ID", json_string( asciitemplateData ) );
-					asciitemplateData = NULL;
-				}
-				unicodeTemplateData = NULL;
-			}
-		}
-		if(!GetTemplateName(templateCountID, &templateCharData)){
-			unicodeTemplateData = (UNSIGNED16*)templateCharData;
-			if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-				if(asciitemplateData){
-					json_object_set_new( rootTemplateElement, "-name", json_string( asciitemplateData ) );
-					asciitemplateData = NULL;
-				}
-				unicodeTemplateData = NULL;
-			}
-		}
-		if(!GetTemplatePresentValueAttributeId(templateCountID, &templateData)){
-			if(!getAsciiFromUnicode(&templateData, &asciitemplateData)){
-				if(asciitemplateData){
-					
-					if(*asciitemplateData >= 7000)
-						json_object_set_new( rootTemplateElement, "-presentValueAttributeId", json_integer( *asciitemplateData ) );
-					
-						asciitemplateData = NULL;
-				}
-				templateData = 0;
-			}
-		}
-		//Property Array
-		if(!GetTemplateKeyPropertyAttributes(templateCountID,&propertyAttributeInfoList)){
-			if(propertyAttributeInfoList){
-				UNSIGNED16 count=0;
-				json_t *json_arr_property = json_array();
-				json_t *json_property = json_object();
-				json_t *json_property_array_object = NULL;
-				json_t *json_property_name_object = NULL;
-				json_t *json_property_description_object = NULL;
-				json_t *json_property_IPunits_object = NULL;
-				json_t *json_property_SIunits_object = NULL;
-				json_t *json_property_measurement_object = NULL;
-				json_t *json_property_IP_Range_object = NULL;
-				json_t *json_property_SI_Range_object = NULL;
-				TEMPLATE_PROPERTY_ATTR_INFO  propertyAttributeInfo;
-				json_object_set_new( rootTemplateElement, "-PropertyList", json_property );
-				json_object_set_new( json_property, "-Property", json_arr_property );
-				for(count=0;count < propertyAttributeInfoList->numtemplatePropertyInfoEntries;count++)
-				{
-					json_property_array_object = json_object();
-					json_property_name_object = json_object();
-					json_property_description_object = json_object();
-					json_property_IPunits_object = json_object();
-					json_property_SIunits_object = json_object();
-					json_property_measurement_object = json_object();
-					json_property_IP_Range_object = json_object();
-					json_property_SI_Range_object = json_object();
-					propertyAttributeInfo = propertyAttributeInfoList->propertyInfo[count];
-					if(json_property_array_object){
-						if(propertyAttributeInfo.attrID >= 7000){
-							json_object_set_new( json_property_array_object, "-ID", json_integer( propertyAttributeInfo.attrID ) );
-						}
-						json_object_set_new( json_property_array_object, "-Required", json_integer( propertyAttributeInfo.required ) );
-						json_object_set_new( json_property_array_object, "-DataType", json_integer( propertyAttributeInfo.dataType ) );
-						if(propertyAttributeInfo.enumSet > 0){
-							json_object_set_new( json_property_array_object, "-StringsetId", json_integer( propertyAttributeInfo.enumSet ) );
-						}
-						if(propertyAttributeInfo.redirectedVals && (propertyAttributeInfo.redirectedEnumSetProp >= 0)){
-								json_object_set_new( json_property_array_object, "-StringsetProperty", json_integer( propertyAttributeInfo.redirectedEnumSetProp ) );
-						}
-						json_object_set_new( json_property_array_object, "-WritableFlag", json_integer( propertyAttributeInfo.attrWritable ) );
-						json_object_set_new( json_property_array_object, "-PriorityFlag", json_integer( propertyAttributeInfo.attrPriority ) );
-						if(propertyAttributeInfo.maxStringLength > 0){
-							json_object_set_new( json_property_array_object, "-MaxStringLength", json_integer( propertyAttributeInfo.maxStringLength ) );
-						}
-						if(propertyAttributeInfo.dispPrec_IP > 0){
-							json_object_set_new( json_property_array_object, "-IPDisplayPrecision", json_integer( propertyAttributeInfo.dispPrec_IP ) );
-						}
-						if(propertyAttributeInfo.dispPrec_SI > 0){
-							json_object_set_new( json_property_array_object, "-SIDisplayPrecision", json_integer( propertyAttributeInfo.dispPrec_SI ) );
-						}
-						if(json_property_name_object){
-							json_object_set_new( json_property_array_object, "-Name", json_property_name_object );
-							json_object_set_new( json_property_name_object, "-setId", json_integer( propertyAttributeInfo.attrNameset ) );
-							json_object_set_new( json_property_name_object, "-value", json_integer( propertyAttributeInfo.attrName ) );
-						}
-						if(json_property_description_object && (0 != propertyAttributeInfo.attrDescriptionset) && (0 != propertyAttributeInfo.attrDescription)){
-							json_object_set_new( json_property_array_object, "-Description", json_property_description_object );
-							json_object_set_new( json_property_description_object, "-setId", json_integer( propertyAttributeInfo.attrDescriptionset ) );
-							json_object_set_new( json_property_description_object, "-value", json_integer( propertyAttributeInfo.attrDescription ) );
-						}
-						if(NO_UNITS == propertyAttributeInfo.units_IP){
-							if(json_property_IPunits_object && (0 != propertyAttributeInfo.units_set) && (0 != propertyAttributeInfo.units_IP)){
-								json_object_set_new( json_property_array_object, "-IPUnits", json_property_IPunits_object );
-								json_object_set_new( json_property_IPunits_object, "-setId", json_integer( propertyAttributeInfo.units_set ) );
-								json_object_set_new( json_property_IPunits_object, "-value", json_integer( propertyAttributeInfo.units_IP ) );
-								if(propertyAttributeInfo.redirectedVals){
-									json_object_set_new( json_property_IPunits_object, "-IPUnitsProperty", json_integer( propertyAttributeInfo.redirectedUnits_IP_Prop ) );
-								}
-							}
-						}
-						if(NO_UNITS == propertyAttributeInfo.units_SI){
-							if(json_property_SIunits_object && (0 != propertyAttributeInfo.units_set) && (0 != propertyAttributeInfo.units_SI)){
-								json_object_set_new( json_property_array_object, "-SIUnits", json_property_SIunits_object );
-								json_object_set_new( json_property_SIunits_object, "-setId", json_integer( propertyAttributeInfo.units_set ) );
-								json_object_set_new( json_property_SIunits_object, "-value", json_integer( propertyAttributeInfo.units_SI ) );
-								if(propertyAttributeInfo.redirectedVals){
-									json_object_set_new( json_property_SIunits_object, "-SIUnitsProperty", json_integer( propertyAttributeInfo.redirectedUnits_SI_Prop ) );
-								}
-							}
-						}
-						if(json_property_measurement_object && (0 !=propertyAttributeInfo.units_set) && (0 != propertyAttributeInfo.measurementType)){
-							json_object_set_new( json_property_array_object, "-MeasurementType", json_property_description_object );
-							json_object_set_new( json_property_description_object, "-setId", json_integer( propertyAttributeInfo.units_set ) );
-							json_object_set_new( json_property_description_object, "-value", json_integer( propertyAttributeInfo.measurementType ) );
-						}
-						if(json_property_IP_Range_object && (0 != propertyAttributeInfo.min_IP) && (0 != propertyAttributeInfo.max_IP)){
-							json_object_set_new( json_property_array_object, "-IPRange", json_property_IP_Range_object );
-							json_object_set_new( json_property_IP_Range_object, "-minvalue", json_real( (FLOAT32)propertyAttributeInfo.min_IP ) );
-							json_object_set_new( json_property_IP_Range_object, "-maxvalue", json_real( (FLOAT32)propertyAttributeInfo.max_IP ) );
-							if(TRUE == propertyAttributeInfo.redirectedVals){
-								json_object_set_new( json_property_IP_Range_object, "-minProperty", json_integer( propertyAttributeInfo.redirectedMin_IP_Prop ) );
-								json_object_set_new( json_property_IP_Range_object, "-maxProperty", json_integer( propertyAttributeInfo.redirectedMax_IP_Prop ) );
-							}
-						}
-						if(json_property_SI_Range_object && (0 != propertyAttributeInfo.min_SI) && (0 != propertyAttributeInfo.max_SI)){
-							json_object_set_new( json_property_array_object, "-SIRange", json_property_SI_Range_object );
-							json_object_set_new( json_property_SI_Range_object, "-minvalue", json_real( (FLOAT32)propertyAttributeInfo.min_SI ) );
-							json_object_set_new( json_property_SI_Range_object, "-maxvalue", json_real( (FLOAT32)propertyAttributeInfo.max_SI ) );
-							if(TRUE == propertyAttributeInfo.redirectedVals){
-								json_object_set_new( json_property_SI_Range_object, "-minProperty", json_integer( propertyAttributeInfo.redirectedMin_SI_Prop ) );
-								json_object_set_new( json_property_SI_Range_object, "-maxProperty", json_integer( propertyAttributeInfo.redirectedMax_SI_Prop ) );
-							}
-						}
-						json_array_append_new(json_arr_property, json_property_array_object );
-					}
-				}
-			}
-		}
-		//subcomponent list
-		if(!GetTemplateSubComponentList(templateCountID,&templateSubComponentInfoList)){
-			if(templateSubComponentInfoList){
-				UNSIGNED16 count=0;
-				json_t *json_arr_component = json_array();
-				json_t *json_component_list = json_object();
-				json_t *json_component_object = NULL;
-				json_t *json_component_label_object = NULL;
-				TEMPLATE_SUBCOMPONENT_INFO templateSubComponentInfo;
-				json_object_set_new( rootTemplateElement, "-SubComponentList", json_component_list );
-				json_object_set_new( json_component_list, "-SubComponent", json_arr_component );
-				for(count=0;count < templateSubComponentInfoList->numSubComponentInfoEntries;count++)
-				{
-					json_component_object = json_object();
-					json_component_label_object = json_object();
-					templateSubComponentInfo = templateSubComponentInfoList->subComponentInfo[count];
-					if(json_component_object){
-
-						if(templateSubComponentInfo.subComponentId){
-							unicodeTemplateData = (UNSIGNED16*)templateSubComponentInfo.subComponentId;
-							if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-								if(asciitemplateData){
-									json_object_set_new( json_component_object, "-Name", json_string( asciitemplateData ) );
-									asciitemplateData = NULL;
-								}
-								unicodeTemplateData = NULL;
-							}
-						}
-
-						json_object_set_new( json_component_object, "-Required", json_integer( templateSubComponentInfo.subComponentRequired ) );
-
-						if(json_component_label_object && (0 != templateSubComponentInfo.subComponentSetId) && (0 != templateSubComponentInfo.subComponentLabelValue)){
-							json_object_set_new( json_component_object, "-label", json_component_label_object );
-							json_object_set_new( json_component_label_object, "-setId", json_integer( templateSubComponentInfo.subComponentSetId ) );
-							json_object_set_new( json_component_label_object, "-value", json_integer( templateSubComponentInfo.subComponentLabelValue ) );
-						}
-						if(templateSubComponentInfo.templateId){
-							unicodeTemplateData = (UNSIGNED16*)templateSubComponentInfo.templateId;
-							if(!getAsciiFromUnicode(unicodeTemplateData, &asciitemplateData)){
-								if(asciitemplateData){
-									json_object_set_new( json_component_object, "-TemplateID", json_string( asciitemplateData ) );
-									asciitemplateData = NULL;
-								}
-								unicodeTemplateData = NULL;
-							}
-						}
+Outputs:  newTemplate - NUL terminated JSON string, acquired with the jansson allocator
+		  as the json_dumps output it replaces, release as before
+------------------------------------------------------------------------------*/
+ERROR_STATUS CreateNewTemplate(char ** newTemplate){
+	
+	JSON_WRITER writer;
+	ERROR_STATUS status;
 
-						json_array_append_new(json_arr_component, json_component_object );
-					}
-				}
-			}
-		}
-		
-		json_array_append_new(json_arr, rootTemplateElement );
-		templateNode = templateNode->next;
-	}
+	*newTemplate = NULL;
 
+	jsonWriterInit(&writer, NULL, NULL);
 
-	s = json_dumps(root, 0);
-	*newTemplate=s;
-	json_decref(root);
-	
-	if(templateDb == NULL)
-		return ERROR_RESPONSE;
+	status = ExportTemplateDatabase(&writer, 0);
+	if(status == OK)
+		status = jsonWriterFinish(&writer);
 
+	//The writer collects into a jansson allocated buffer, handed out as is
+	if(status == OK)
+		*newTemplate = (char *)jsonWriterDetach(&writer);
+	else
+		jsonWriterRelease(&writer);
 	
-	
-	return OK;
+	return status;
 }
-
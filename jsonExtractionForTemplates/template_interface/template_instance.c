@@ -0,0 +1,574 @@
+/*------------------------------------------------------------------------------
+
+Module:   Template Instance Cache
+
+Purpose:  Holds, per equipment object, the template properties whose units, enum set
+          or min/max are redirected to attributes of the equipment object. The values
+          are read into the object's own copy of the property, so instances no longer
+          overwrite each other's values in the shared template. The copy is only kept
+          across calls for an object that reports the changes of its attributes
+          (EnableTemplateInstanceCache), until InvalidateTemplateInstanceCache reports
+          a change of a source attribute; for any other object it is read again on
+          every call.
+
+Filename: template_instance.c
+
+Inputs:   Equipment object Id (internal OID) the values belong to
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+#include <template_api.h>
+#include "template_api_private.h"
+#include <enum.h>
+
+#ifdef USE_DOUBLE
+#define REDIRECT_REAL_DATA_TYPE     DOUBLE_DATA_TYPE
+#define REDIRECT_REAL_VALUE(parm)   ((parm).parmValue.tDouble)
+#else
+#define REDIRECT_REAL_DATA_TYPE     FLOAT_DATA_TYPE
+#define REDIRECT_REAL_VALUE(parm)   ((parm).parmValue.tFloat)
+#endif
+
+//Number of redirected values a property can have
+#define REDIRECT_VALUES_PER_PROPERTY    7
+
+//Read table entries kept on the stack, larger batches allocate the table
+#define REDIRECT_READ_STACK_SIZE        (REDIRECT_VALUES_PER_PROPERTY * 4)
+
+//Upper bound of the read table's hash size
+#define REDIRECT_READ_HASH_MAX_SIZE     256
+
+//Read table hash key, the attribute Id in the low bits the integer hash uses
+#define REDIRECT_READ_KEY(sourceAttrId, dataType)   (((UNSIGNED32)(dataType) << 16) | (sourceAttrId))
+
+//One read of an equipment object attribute, shared by every property redirected to it
+typedef struct
+{
+	UNSIGNED16 sourceAttrId;
+	UNSIGNED16 dataType;
+	ERROR_STATUS readStatus;
+	PARM_DATA parm;
+} REDIRECT_READ;
+
+/*------------------------------------------------------------------------------
+Module:   redirectRead method
+
+Purpose:  Returns the read of an equipment object attribute from the read table,
+          reading it only the first time it is asked for. The entries are found by
+          attribute Id and data type through the read table's hash.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+          readHash - Hash of the read table, REDIRECT_READ_KEY and its entry
+          reads - Read table
+          numReads - Number of entries used in the read table
+          sourceAttrId - Attribute to read
+          dataType - Data type to read it as
+
+Outputs:  The read table entry, check its readStatus
+------------------------------------------------------------------------------*/
+static REDIRECT_READ * redirectRead(OID_TYPE equipObjId, APSHASHTBL * readHash, REDIRECT_READ * reads, UNSIGNED32 * numReads, UNSIGNED16 sourceAttrId, UNSIGNED16 dataType)
+{
+	UNSIGNED32 key = REDIRECT_READ_KEY(sourceAttrId, dataType);
+	REDIRECT_READ * read;
+
+	if(!hashtbl_get(readHash, &key, sizeof(key), (void **)&read))
+		return read;
+
+	read = &reads[(*numReads)++];
+	read->sourceAttrId = sourceAttrId;
+	read->dataType = dataType;
+	read->readStatus = stdReadInternalAttr(equipObjId, sourceAttrId, &read->parm, dataType);
+
+	//An entry that could not be added is still valid, a later ask reads it again
+	hashtbl_insert(readHash, &key, read, sizeof(key));
+
+	return read;
+}
+
+/*------------------------------------------------------------------------------
+Module:   readTemplateRedirectedValuesList method
+
+Purpose:  Reads the redirected values (enum set, IP/SI units, IP/SI min/max) of a set
+          of properties from the equipment object. Every source attribute is read
+          once, however many properties are redirected to it. Values that cannot be
+          read keep the template's value.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+          attrInfos - Properties to fill, normally instance copies
+          numAttrInfos - Number of properties
+
+Outputs:  readComplete - Per property, TRUE if all its redirected values were read
+                         (may be NULL)
+          ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS readTemplateRedirectedValuesList(OID_TYPE equipObjId, TEMPLATE_PROPERTY_ATTR_INFO ** attrInfos, UNSIGNED16 numAttrInfos, UNSIGNED8 * readComplete)
+{
+	REDIRECT_READ stackReads[REDIRECT_READ_STACK_SIZE];
+	REDIRECT_READ * reads = stackReads;
+	REDIRECT_READ * read;
+	APSHASHTBL * readHash;
+	TEMPLATE_PROPERTY_ATTR_INFO * attrInfo;
+	UNSIGNED32 maxReads = (UNSIGNED32)numAttrInfos * REDIRECT_VALUES_PER_PROPERTY;
+	UNSIGNED32 numReads = 0;
+	UNSIGNED16 index;
+	UNSIGNED8 complete;
+
+	if(numAttrInfos == 0)
+		return OK;
+
+	if(maxReads > REDIRECT_READ_STACK_SIZE)
+	{
+		reads = (REDIRECT_READ *)OSacquire(sizeof(REDIRECT_READ) * maxReads);
+		if(reads == NULL)
+			return NOT_ENOUGH_MEMORY;
+	}
+
+	//Hash list of the read table - (attribute Id, data type) and its read entry
+	readHash = hashtbl_create((hashSize)(maxReads < REDIRECT_READ_HASH_MAX_SIZE ? maxReads : REDIRECT_READ_HASH_MAX_SIZE), HASH_TYPE_INT);
+	if(readHash == NULL)
+	{
+		if(reads != stackReads)
+			OSrelease(reads);
+		return HASH_CREATE_ERROR;
+	}
+
+	for(index = 0; index < numAttrInfos; index++)
+	{
+		attrInfo = attrInfos[index];
+		complete = TRUE;
+
+		if (attrInfo->redirectedEnumSetProp)
+		{
+			read = redirectRead(equipObjId, readHash, reads, &numReads, attrInfo->redirectedEnumSetProp, ENUM_DATA_TYPE);
+			if (read->readStatus == OK)
+				attrInfo->enumSet = read->parm.parmValue.tEnum;
+			else
+				complete = FALSE;
+		}
+		if (attrInfo->redirectedUnits_IP_Prop)
+		{
+			read = redirectRead(equipObjId, readHash, reads, &numReads, attrInfo->redirectedUnits_IP_Prop, ENUM_DATA_TYPE);
+			if (read->readStatus == OK)
+				attrInfo->units_IP = read->parm.parmValue.tEnum;
+			else
+				complete = FALSE;
+		}
+		if (attrInfo->redirectedUnits_SI_Prop)
+		{
+			read = redirectRead(equipObjId, readHash, reads, &numReads, attrInfo->redirectedUnits_SI_Prop, ENUM_DATA_TYPE);
+			if (read->readStatus == OK)
+				attrInfo->units_SI = read->parm.parmValue.tEnum;
+			else
+				complete = FALSE;
+		}
+		if (attrInfo->redirectedMin_IP_Prop)
+		{
+			read = redirectRead(equipObjId, readHash, reads, &numReads, attrInfo->redirectedMin_IP_Prop, REDIRECT_REAL_DATA_TYPE);
+			if (read->readStatus == OK)
+				attrInfo->min_IP = REDIRECT_REAL_VALUE(read->parm);
+			else
+				complete = FALSE;
+		}
+		if (attrInfo->redirectedMax_IP_Prop)
+		{
+			read = redirectRead(equipObjId, readHash, reads, &numReads, attrInfo->redirectedMax_IP_Prop, REDIRECT_REAL_DATA_TYPE);
+			if (read->readStatus == OK)
+				attrInfo->max_IP = REDIRECT_REAL_VALUE(read->parm);
+			else
+				complete = FALSE;
+		}
+		if (attrInfo->redirectedMin_SI_Prop)
+		{
+			read = redirectRead(equipObjId, readHash, reads, &numReads, attrInfo->redirectedMin_SI_Prop, REDIRECT_REAL_DATA_TYPE);
+			if (read->readStatus == OK)
+				attrInfo->min_SI = REDIRECT_REAL_VALUE(read->parm);
+			else
+				complete = FALSE;
+		}
+		if (attrInfo->redirectedMax_SI_Prop)
+		{
+			read = redirectRead(equipObjId, readHash, reads, &numReads, attrInfo->redirectedMax_SI_Prop, REDIRECT_REAL_DATA_TYPE);
+			if (read->readStatus == OK)
+				attrInfo->max_SI = REDIRECT_REAL_VALUE(read->parm);
+			else
+				complete = FALSE;
+		}
+
+		if(readComplete != NULL)
+			readComplete[index] = complete;
+	}
+
+	hashtbl_destroy(readHash);
+
+	if(reads != stackReads)
+		OSrelease(reads);
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   readTemplateRedirectedValues method
+
+Purpose:  Reads the redirected values of a single property from the equipment object.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+          attrInfo - Property to fill, normally the instance copy
+
+Outputs:  TRUE if all the redirected values were read, FALSE if some kept the
+          template's value
+------------------------------------------------------------------------------*/
+UNSIGNED8 readTemplateRedirectedValues(OID_TYPE equipObjId, TEMPLATE_PROPERTY_ATTR_INFO * attrInfo)
+{
+	UNSIGNED8 complete = FALSE;
+
+	readTemplateRedirectedValuesList(equipObjId, &attrInfo, 1, &complete);
+
+	return complete;
+}
+
+/*------------------------------------------------------------------------------
+Module:   usesSourceAttribute method
+
+Purpose:  Tells whether a property takes one of its redirected values from the given
+          attribute of the equipment object.
+
+Inputs:   attrInfo - Property
+          sourceAttrId - Attribute Id of the equipment object
+
+Outputs:  TRUE or FALSE
+------------------------------------------------------------------------------*/
+static UNSIGNED8 usesSourceAttribute(TEMPLATE_PROPERTY_ATTR_INFO * attrInfo, UNSIGNED16 sourceAttrId)
+{
+	return (attrInfo->redirectedEnumSetProp == sourceAttrId ||
+		attrInfo->redirectedUnits_IP_Prop == sourceAttrId ||
+		attrInfo->redirectedUnits_SI_Prop == sourceAttrId ||
+		attrInfo->redirectedMin_IP_Prop == sourceAttrId ||
+		attrInfo->redirectedMax_IP_Prop == sourceAttrId ||
+		attrInfo->redirectedMin_SI_Prop == sourceAttrId ||
+		attrInfo->redirectedMax_SI_Prop == sourceAttrId) ? TRUE : FALSE;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getInstanceCache method
+
+Purpose:  Returns the cache of an equipment object, creating it when asked to.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+          create - TRUE to create the cache if the object has none
+
+Outputs:  instanceCache - Cache of the object
+          TEMPLATE_NOT_FOUND if the object has no cache and create is FALSE
+------------------------------------------------------------------------------*/
+static ERROR_STATUS getInstanceCache(OID_TYPE equipObjId, UNSIGNED8 create, TEMPLATE_INSTANCE_CACHE ** instanceCache)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = NULL;
+	TEMPLATE_INSTANCE_CACHE * cache = NULL;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+	ERROR_STATUS status;
+
+	// get ptr to the model's class vars
+	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+	templateDbExt = (TEMPLATE_DATABASE_EXT *)classVarPtr->template_database;
+	if(templateDbExt == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	if(templateDbExt->instanceCacheHash != NULL &&
+		!hashtbl_get(templateDbExt->instanceCacheHash, &equipObjId, sizeof(equipObjId), (void **)instanceCache))
+		return OK;
+
+	if(!create)
+		return TEMPLATE_NOT_FOUND;
+
+	//Hash list to store the equipment object Id and its cache, created on first use
+	if(templateDbExt->instanceCacheHash == NULL)
+	{
+		if((templateDbExt->instanceCacheHash = hashtbl_create(TEMPLATE_INSTANCE_DB_ENTRY_GROW_SIZE, HASH_TYPE_INT)) == NULL)
+			return HASH_CREATE_ERROR;
+	}
+
+	cache = (TEMPLATE_INSTANCE_CACHE *)OSacquire(sizeof(TEMPLATE_INSTANCE_CACHE));
+	if(cache == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	cache->equipObjId = equipObjId;
+	cache->notified = FALSE;
+	if((cache->propertyHash = hashtbl_create(TEMPLATE_INSTANCE_PROPERTY_GROW_SIZE, HASH_TYPE_INT)) == NULL)
+	{
+		OSrelease(cache);
+		return HASH_CREATE_ERROR;
+	}
+
+	status = hashtbl_insert(templateDbExt->instanceCacheHash, &cache->equipObjId, cache, sizeof(cache->equipObjId));
+	if(status != OK)
+	{
+		hashtbl_destroy(cache->propertyHash);
+		OSrelease(cache);
+		return status;
+	}
+
+	*instanceCache = cache;
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getInstanceProperty method
+
+Purpose:  Returns the cache slot of a property in an equipment object's cache, adding
+          an invalid slot if the property is not cached yet.
+
+Inputs:   cache - Cache of the equipment object
+          templateId - Template Id of the property
+          attrInfo - Property as held by the template
+
+Outputs:  instanceProperty - Cache slot of the property
+------------------------------------------------------------------------------*/
+static ERROR_STATUS getInstanceProperty(TEMPLATE_INSTANCE_CACHE * cache, UNSIGNED16 templateId, TEMPLATE_PROPERTY_ATTR_INFO * attrInfo, TEMPLATE_INSTANCE_PROPERTY ** instanceProperty)
+{
+	UNSIGNED32 key = TEMPLATE_INSTANCE_KEY(templateId, attrInfo->attrID);
+	TEMPLATE_INSTANCE_PROPERTY * property = NULL;
+	ERROR_STATUS status;
+
+	if(hashtbl_get(cache->propertyHash, &key, sizeof(key), (void **)&property))
+	{
+		property = (TEMPLATE_INSTANCE_PROPERTY *)OSacquire(sizeof(TEMPLATE_INSTANCE_PROPERTY));
+		if(property == NULL)
+			return NOT_ENOUGH_MEMORY;
+
+		property->valid = FALSE;
+
+		status = hashtbl_insert(cache->propertyHash, &key, property, sizeof(key));
+		if(status != OK)
+		{
+			OSrelease(property);
+			return status;
+		}
+	}
+
+	*instanceProperty = property;
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getTemplateInstancePropertyInfo method
+
+Purpose:  This is a private method and used internally by GetTemplatePropertyInfo.
+          Returns the equipment object's copy of a property with its redirected values,
+          reading them from the object unless a kept copy is still valid.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+          templateId - Template Id of the property
+          attrInfo - Property as held by the template
+
+Outputs:  instancePropertyInfo - Copy owned by the object's cache. The pointer stays the
+          same until ReleaseTemplateInstanceCache is called for the object.
+------------------------------------------------------------------------------*/
+ERROR_STATUS getTemplateInstancePropertyInfo(OID_TYPE equipObjId, UNSIGNED16 templateId, TEMPLATE_PROPERTY_ATTR_INFO * attrInfo, TEMPLATE_PROPERTY_ATTR_INFO ** instancePropertyInfo)
+{
+	TEMPLATE_INSTANCE_CACHE * cache = NULL;
+	TEMPLATE_INSTANCE_PROPERTY * instanceProperty = NULL;
+	ERROR_STATUS status;
+
+	status = getInstanceCache(equipObjId, TRUE, &cache);
+	if(status != OK)
+		return status;
+
+	status = getInstanceProperty(cache, templateId, attrInfo, &instanceProperty);
+	if(status != OK)
+		return status;
+
+	if(!instanceProperty->valid)
+	{
+		//Start from the template's values so unreadable attributes keep the default,
+		//the copy is only kept when every value was read and changes get reported
+		instanceProperty->propertyInfo = *attrInfo;
+		instanceProperty->valid = readTemplateRedirectedValues(equipObjId, &instanceProperty->propertyInfo) && cache->notified;
+	}
+
+	*instancePropertyInfo = &instanceProperty->propertyInfo;
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getTemplateInstancePropertyInfoList method
+
+Purpose:  This is a private method and used internally by GetTemplatePropertyInfoList.
+          Replaces every property with redirected values in the list by the equipment
+          object's copy. All copies needing a (re-)read are read in one pass with
+          the reads shared between properties; a copy is kept for later calls only
+          when all its values were read and the object reports its changes.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+          templateId - Template Id of the properties
+          propertyInfos - Properties as held by the template, NULL entries are skipped
+          numPropertyInfos - Number of entries
+
+Outputs:  propertyInfos - Updated in place on success, left untouched otherwise
+------------------------------------------------------------------------------*/
+ERROR_STATUS getTemplateInstancePropertyInfoList(OID_TYPE equipObjId, UNSIGNED16 templateId, TEMPLATE_PROPERTY_ATTR_INFO ** propertyInfos, UNSIGNED16 numPropertyInfos)
+{
+	TEMPLATE_INSTANCE_CACHE * cache = NULL;
+	TEMPLATE_INSTANCE_PROPERTY * instanceProperty = NULL;
+	TEMPLATE_PROPERTY_ATTR_INFO ** staleInfos = NULL;
+	TEMPLATE_PROPERTY_ATTR_INFO ** instanceInfos;
+	UNSIGNED8 * readComplete;
+	UNSIGNED16 numStaleInfos = 0;
+	UNSIGNED16 index;
+	ERROR_STATUS status;
+	ERROR_STATUS errorStatus;
+
+	if(numPropertyInfos == 0)
+		return OK;
+
+	status = getInstanceCache(equipObjId, TRUE, &cache);
+	if(status != OK)
+		return status;
+
+	//Stale copies to read, the output built aside and copied out on success, then the
+	//read result of each stale copy
+	staleInfos = (TEMPLATE_PROPERTY_ATTR_INFO **)OSacquire((sizeof(TEMPLATE_PROPERTY_ATTR_INFO *) * 2 + sizeof(UNSIGNED8)) * (UNSIGNED32)numPropertyInfos);
+	if(staleInfos == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	instanceInfos = staleInfos + numPropertyInfos;
+	readComplete = (UNSIGNED8 *)(instanceInfos + numPropertyInfos);
+	OSmemcpy(instanceInfos, propertyInfos, sizeof(TEMPLATE_PROPERTY_ATTR_INFO *) * numPropertyInfos);
+
+	for(index = 0; index < numPropertyInfos; index++)
+	{
+		if(instanceInfos[index] == NULL || !instanceInfos[index]->redirectedVals)
+			continue;
+
+		status = getInstanceProperty(cache, templateId, instanceInfos[index], &instanceProperty);
+		if(status != OK)
+			break;
+
+		if(!instanceProperty->valid)
+		{
+			//Start from the template's values so unreadable attributes keep the default
+			instanceProperty->propertyInfo = *instanceInfos[index];
+			staleInfos[numStaleInfos++] = &instanceProperty->propertyInfo;
+		}
+
+		instanceInfos[index] = &instanceProperty->propertyInfo;
+	}
+
+	if(numStaleInfos > 0)
+	{
+		errorStatus = readTemplateRedirectedValuesList(equipObjId, staleInfos, numStaleInfos, readComplete);
+
+		//Copies with a value left unread stay stale to be read again on the next call
+		for(index = 0; index < numStaleInfos; index++)
+			((TEMPLATE_INSTANCE_PROPERTY *)staleInfos[index])->valid = (errorStatus == OK && readComplete[index] && cache->notified);
+
+		if(status == OK)
+			status = errorStatus;
+	}
+
+	if(status == OK)
+		OSmemcpy(propertyInfos, instanceInfos, sizeof(TEMPLATE_PROPERTY_ATTR_INFO *) * numPropertyInfos);
+
+	OSrelease(staleInfos);
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   EnableTemplateInstanceCache method
+
+Purpose:  This is a public accessible method, called by an equipment object that
+          calls InvalidateTemplateInstanceCache whenever one of its attributes
+          changes. From then on the object's copies are kept across calls instead of
+          being read again on every GetTemplatePropertyInfo; without the notification
+          a kept copy could not be told apart from a changed value.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS EnableTemplateInstanceCache(OID_TYPE equipObjId)
+{
+	TEMPLATE_INSTANCE_CACHE * cache = NULL;
+	ERROR_STATUS status;
+
+	status = getInstanceCache(equipObjId, TRUE, &cache);
+	if(status == OK)
+		cache->notified = TRUE;
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   InvalidateTemplateInstanceCache method
+
+Purpose:  This is a public accessible method, called by the equipment object when one
+          of its attributes changed. Every cached property taking a redirected value
+          from that attribute is re-read on its next GetTemplatePropertyInfo.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+          sourceAttrId - Attribute Id that changed, 0 to invalidate every property
+                         of the object
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS InvalidateTemplateInstanceCache(OID_TYPE equipObjId, UNSIGNED16 sourceAttrId)
+{
+	TEMPLATE_INSTANCE_CACHE * cache = NULL;
+	TEMPLATE_INSTANCE_PROPERTY * instanceProperty;
+	struct hashEntry_s * node;
+	hashIndex idx;
+
+	//Nothing cached for this object, nothing to invalidate
+	if(getInstanceCache(equipObjId, FALSE, &cache) != OK)
+		return OK;
+
+	for(idx = 0; idx < cache->propertyHash->size; idx++)
+	{
+		for(node = cache->propertyHash->nodes[idx]; node != NULL; node = node->next)
+		{
+			instanceProperty = (TEMPLATE_INSTANCE_PROPERTY *)node->data;
+			if(sourceAttrId == 0 || usesSourceAttribute(&instanceProperty->propertyInfo, sourceAttrId))
+				instanceProperty->valid = FALSE;
+		}
+	}
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   ReleaseTemplateInstanceCache method
+
+Purpose:  This is a public accessible method, called when an equipment object is
+          deleted. Releases the object's cached properties; pointers returned by
+          GetTemplatePropertyInfo for this object are no longer valid afterwards.
+
+Inputs:   equipObjId - Internal OID of the equipment object
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS ReleaseTemplateInstanceCache(OID_TYPE equipObjId)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = NULL;
+	TEMPLATE_INSTANCE_CACHE * cache = NULL;
+	MODEL_CLASS_VARS *classVarPtr = NULL;
+	struct hashEntry_s * node;
+	hashIndex idx;
+
+	if(getInstanceCache(equipObjId, FALSE, &cache) != OK)
+		return OK;
+
+	for(idx = 0; idx < cache->propertyHash->size; idx++)
+		for(node = cache->propertyHash->nodes[idx]; node != NULL; node = node->next)
+			OSrelease(node->data);
+
+	hashtbl_destroy(cache->propertyHash);
+
+	// get ptr to the model's class vars
+	classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+	templateDbExt = (TEMPLATE_DATABASE_EXT *)classVarPtr->template_database;
+
+	hashtbl_remove(templateDbExt->instanceCacheHash, &equipObjId, sizeof(equipObjId));
+	OSrelease(cache);
+
+	return OK;
+}
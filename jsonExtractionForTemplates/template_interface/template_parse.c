@@ -180,6 +180,14 @@ ERROR_STATUS AddTemplateToHash(UNSIGNED16 * interfaceName, json_t * jsonTemplate
                 hashtbl_remove(templateDb->templateHash, interfaceName, STR_STORE(OSstrlen(interfaceName)));
                 return TEMPLATE_PARSE_ERROR;	
             }
+
+            //4. Stamp the template with a new database generation for the delta export,
+            //it is part of the export from now on.
+            status = MarkTemplateAdded(templateDb, templateDb->templateCount);
+
+            //5. Add the template to the attribute and subcomponent reverse indexes.
+            if(!status)
+                status = IndexTemplateReferences(templateDb, templateDb->templateCount);
         }
         else
         {
@@ -194,6 +202,182 @@ ERROR_STATUS AddTemplateToHash(UNSIGNED16 * interfaceName, json_t * jsonTemplate
 
 
 
+/*------------------------------------------------------------------------------
+Module:   sortTemplateProperties method
+
+Purpose:  Sorts a template's property array by attribute Id. Insertion sort - the
+          property lists are mostly in attribute Id order already.
+
+Inputs:   propertyArray - Properties of the template
+          numProperties - Number of properties
+
+Outputs:  None
+------------------------------------------------------------------------------*/
+static void sortTemplateProperties(TEMPLATE_PROPERTY_ATTR_INFO * propertyArray, UNSIGNED16 numProperties)
+{
+    TEMPLATE_PROPERTY_ATTR_INFO propertyInfo;
+    UNSIGNED16 index, position;
+
+    for(index = 1; index < numProperties; index++)
+    {
+        if(propertyArray[index - 1].attrID <= propertyArray[index].attrID)
+            continue;
+
+        propertyInfo = propertyArray[index];
+        for(position = index; position > 0 && propertyArray[position - 1].attrID > propertyInfo.attrID; position--)
+            propertyArray[position] = propertyArray[position - 1];
+
+        propertyArray[position] = propertyInfo;
+    }
+}
+
+/*------------------------------------------------------------------------------
+Module:   buildTemplateMembershipFilter method
+
+Purpose:  Builds the attribute membership filter of a template from its sorted
+          attribute Id column: an exact bitset over [lowest Id, highest Id] when the
+          span is small, a blocked Bloom filter sized from the property count otherwise.
+
+Inputs:   entryExt - Template entry with its attribute Id column built
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS buildTemplateMembershipFilter(TEMPLATE_ENTRY_EXT * entryExt)
+{
+    TEMPLATE_MEMBERSHIP_FILTER * membership = &entryExt->membership;
+    UNSIGNED16 numProperties = entryExt->numProperties;
+    UNSIGNED16 * attrIds = entryExt->propertyAttrIds;
+    UNSIGNED32 span, numBlocks, hash, offset;
+    UNSIGNED16 index;
+
+    if(numProperties == 0)
+        return OK;
+
+    span = (UNSIGNED32)attrIds[numProperties - 1] - attrIds[0] + 1;
+
+    if(span <= TEMPLATE_MEMBERSHIP_BITSET_MAX_SPAN)
+    {
+        membership->base = attrIds[0];
+        membership->span = (UNSIGNED16)span;
+        numBlocks = (span + 31) / 32;
+    }
+    else
+    {
+        //Power of two number of 32 bit blocks
+        numBlocks = 1;
+        while(numBlocks * 32 < (UNSIGNED32)numProperties * TEMPLATE_MEMBERSHIP_BLOOM_BITS_PER_ID)
+            numBlocks *= 2;
+
+        membership->span = 0;
+        membership->blockMask = (UNSIGNED16)(numBlocks - 1);
+    }
+
+    membership->bits = (UNSIGNED32 *)OSacquire(sizeof(UNSIGNED32) * numBlocks);
+    if(membership->bits == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    OSmemset(membership->bits, 0, sizeof(UNSIGNED32) * numBlocks);
+
+    for(index = 0; index < numProperties; index++)
+    {
+        if(membership->span)
+        {
+            offset = attrIds[index] - membership->base;
+            membership->bits[offset / 32] |= 1UL << (offset % 32);
+        }
+        else
+        {
+            hash = TEMPLATE_MEMBERSHIP_HASH(attrIds[index]);
+            membership->bits[TEMPLATE_MEMBERSHIP_BLOCK(hash, membership->blockMask)] |= TEMPLATE_MEMBERSHIP_BITS(hash);
+        }
+    }
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   buildTemplatePropertyColumns method
+
+Purpose:  Splits a template's sorted property array into the template's property
+          storage: the hot field columns (attribute Id for the lookup, data type and
+          TEMPLATE_PROPERTY_FLAG_xxx for the filtered scans) and the cold array with
+          the remaining fields, in one allocation. Then builds the attribute
+          membership filter. The property array is not kept.
+
+Inputs:   entryExt - Template entry with numProperties set
+          propertyArray - Properties sorted by attribute Id
+
+Outputs:  ERROR_STATUS, TEMPLATE_PARSE_ERROR if two properties have the same
+          attribute Id
+------------------------------------------------------------------------------*/
+ERROR_STATUS buildTemplatePropertyColumns(TEMPLATE_ENTRY_EXT * entryExt, const TEMPLATE_PROPERTY_ATTR_INFO * propertyArray)
+{
+    const TEMPLATE_PROPERTY_ATTR_INFO * propertyInfo;
+    TEMPLATE_PROPERTY_COLD_INFO * coldInfo;
+    UNSIGNED16 numProperties = entryExt->numProperties;
+    UNSIGNED8 * columns;
+    UNSIGNED16 index;
+
+    if(numProperties == 0)
+        return OK;
+
+    //The lookup needs each attribute Id once, equal Ids are adjacent once sorted
+    for(index = 1; index < numProperties; index++)
+    {
+        if(propertyArray[index - 1].attrID >= propertyArray[index].attrID)
+            return TEMPLATE_PARSE_ERROR;
+    }
+
+    //Cold array first, it has the widest alignment
+    columns = (UNSIGNED8 *)OSacquire((sizeof(TEMPLATE_PROPERTY_COLD_INFO) + sizeof(UNSIGNED16) + 2 * sizeof(UNSIGNED8)) * numProperties);
+    if(columns == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    entryExt->propertyColdInfo = (TEMPLATE_PROPERTY_COLD_INFO *)columns;
+    entryExt->propertyAttrIds = (UNSIGNED16 *)(columns + sizeof(TEMPLATE_PROPERTY_COLD_INFO) * numProperties);
+    entryExt->propertyDataTypes = (UNSIGNED8 *)(entryExt->propertyAttrIds + numProperties);
+    entryExt->propertyFlags = entryExt->propertyDataTypes + numProperties;
+
+    for(index = 0; index < numProperties; index++)
+    {
+        propertyInfo = &propertyArray[index];
+        coldInfo = &entryExt->propertyColdInfo[index];
+
+        entryExt->propertyAttrIds[index] = propertyInfo->attrID;
+        entryExt->propertyDataTypes[index] = propertyInfo->dataType;
+        entryExt->propertyFlags[index] = (propertyInfo->attrWritable ? TEMPLATE_PROPERTY_FLAG_WRITABLE : 0) |
+                                         (propertyInfo->attrPriority ? TEMPLATE_PROPERTY_FLAG_PRIORITY : 0) |
+                                         (propertyInfo->required ? TEMPLATE_PROPERTY_FLAG_REQUIRED : 0);
+
+        coldInfo->min_IP = propertyInfo->min_IP;
+        coldInfo->max_IP = propertyInfo->max_IP;
+        coldInfo->min_SI = propertyInfo->min_SI;
+        coldInfo->max_SI = propertyInfo->max_SI;
+        coldInfo->enumSet = propertyInfo->enumSet;
+        coldInfo->redirectedEnumSetProp = propertyInfo->redirectedEnumSetProp;
+        coldInfo->dispPrec_IP = propertyInfo->dispPrec_IP;
+        coldInfo->dispPrec_SI = propertyInfo->dispPrec_SI;
+        coldInfo->attrNameset = propertyInfo->attrNameset;
+        coldInfo->attrName = propertyInfo->attrName;
+        coldInfo->attrDescriptionset = propertyInfo->attrDescriptionset;
+        coldInfo->attrDescription = propertyInfo->attrDescription;
+        coldInfo->units_set = propertyInfo->units_set;
+        coldInfo->units_IP = propertyInfo->units_IP;
+        coldInfo->units_SI = propertyInfo->units_SI;
+        coldInfo->measurementType = propertyInfo->measurementType;
+        coldInfo->redirectedUnits_IP_Prop = propertyInfo->redirectedUnits_IP_Prop;
+        coldInfo->redirectedUnits_SI_Prop = propertyInfo->redirectedUnits_SI_Prop;
+        coldInfo->redirectedMin_IP_Prop = propertyInfo->redirectedMin_IP_Prop;
+        coldInfo->redirectedMax_IP_Prop = propertyInfo->redirectedMax_IP_Prop;
+        coldInfo->redirectedMin_SI_Prop = propertyInfo->redirectedMin_SI_Prop;
+        coldInfo->redirectedMax_SI_Prop = propertyInfo->redirectedMax_SI_Prop;
+        coldInfo->redirectedVals = propertyInfo->redirectedVals;
+        coldInfo->maxStringLength = propertyInfo->maxStringLength;
+    }
+
+    return buildTemplateMembershipFilter(entryExt);
+}
+
 ERROR_STATUS templateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, UNSIGNED16 templateKey)
 {
     //Declare fields 
@@ -228,6 +412,11 @@ ERROR_STATUS templateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, UNSIGN
     UNSIGNED32 propertyCount;
     UNSIGNED32 temp;
 
+    TEMPLATE_PROPERTY_ATTR_INFO * propertyArray = NULL;
+    UNSIGNED16 numProperties = 0;
+    TEMPLATE_SUBCOMPONENT_INFO * subcomponentArray = NULL;
+    UNSIGNED16 numSubComponents = 0;
+
     if(jsonTemplate != NULL)
     {
         //Create attribute and subcomponent hash
@@ -241,7 +430,10 @@ ERROR_STATUS templateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, UNSIGN
         }
 
         //Allocate memory for template entry
-        templateEntry = (TEMPLATE_ENTRY *)OSacquire(sizeof(TEMPLATE_ENTRY));
+        templateEntry = (TEMPLATE_ENTRY *)OSacquire(sizeof(TEMPLATE_ENTRY_EXT));
+        if(templateEntry == NULL)
+            return NOT_ENOUGH_MEMORY;
+        OSmemset(templateEntry, 0, sizeof(TEMPLATE_ENTRY_EXT));
 
         //Iterate through template properties
         iter = json_object_iter(jsonTemplate);
@@ -364,11 +556,22 @@ ERROR_STATUS templateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, UNSIGN
                     //Get the number of properties associated.
                     propertyCount = json_array_size(jsonPropertyArray);	
 
+                    //All properties of the template are held in one array
+                    if(propertyCount > 0)
+                    {
+                        propertyArray = (TEMPLATE_PROPERTY_ATTR_INFO *)OSacquire(sizeof(TEMPLATE_PROPERTY_ATTR_INFO) * propertyCount);
+                        if(propertyArray == NULL)
+                            return NOT_ENOUGH_MEMORY;
+
+                        OSmemset(propertyArray, 0, sizeof(TEMPLATE_PROPERTY_ATTR_INFO) * propertyCount);
+                        numProperties = (UNSIGNED16)propertyCount;
+                    }
+
                     //Loop through the array
                     for(temp = 0; temp < propertyCount; temp++)
                     {
-                        //Allocate space for property structure
-                        propertyAttributeInfo = (TEMPLATE_PROPERTY_ATTR_INFO *)OSacquire(sizeof(TEMPLATE_PROPERTY_ATTR_INFO));
+                        //Property structure within the template's array
+                        propertyAttributeInfo = &propertyArray[temp];
 
                         //initialize the enumSet to be FALSETRUE_ENUM_SET as default - to be used for bool and enum types 
                         propertyAttributeInfo->enumSet = FALSETRUE_ENUM_SET;
@@ -604,13 +807,10 @@ ERROR_STATUS templateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, UNSIGN
                             /* use key and value ... */
                             propertyiter = json_object_iter_next(jsonPropertyData, propertyiter);
                         }
+                    }
 
-                        //Add to property hash
-                        status = hashtbl_insert(attributeHashInfo, &propertyAttributeInfo->attrID, propertyAttributeInfo, sizeof(propertyAttributeInfo->attrID));
-                        if (status != OK)
-                            return status;
-
-                    }					
+                    //Sort by attribute Id for the binary search
+                    sortTemplateProperties(propertyArray, numProperties);
                 }
             }
             else if(!OSstrcmp(unicodetemplKey, _T("-SubComponentList")))
@@ -621,12 +821,22 @@ ERROR_STATUS templateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, UNSIGN
                     //Get the number of properties associated.
                     propertyCount = json_array_size(jsonSubComponentArray);	
 
+                    //All subcomponents of the template are held in one array, in file order
+                    if(propertyCount > 0)
+                    {
+                        subcomponentArray = (TEMPLATE_SUBCOMPONENT_INFO *)OSacquire(sizeof(TEMPLATE_SUBCOMPONENT_INFO) * propertyCount);
+                        if(subcomponentArray == NULL)
+                            return NOT_ENOUGH_MEMORY;
+
+                        OSmemset(subcomponentArray, 0, sizeof(TEMPLATE_SUBCOMPONENT_INFO) * propertyCount);
+                        numSubComponents = (UNSIGNED16)propertyCount;
+                    }
 
                     //Loop through the array
                     for(temp = 0; temp < propertyCount; temp++)
                     {
-                        //Allocate space for property structure
-                        subcomponentInfo = (TEMPLATE_SUBCOMPONENT_INFO *)OSacquire(sizeof(TEMPLATE_SUBCOMPONENT_INFO));
+                        //Subcomponent structure within the template's array
+                        subcomponentInfo = &subcomponentArray[temp];
 
                         //Get each index object
                         jsonPropertyData = json_array_get(jsonSubComponentArray, temp);
@@ -717,8 +927,20 @@ ERROR_STATUS templateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, UNSIGN
 
         }
 
-        //Add property info to template structure
+        //Add property info to template structure, the attribute hash is filled along
+        //with the property records on first use
         templateEntry->templateAttrInfo = attributeHashInfo;
+        ((TEMPLATE_ENTRY_EXT *)templateEntry)->numProperties = numProperties;
+        ((TEMPLATE_ENTRY_EXT *)templateEntry)->subComponentList.numSubComponentInfoEntries = numSubComponents;
+        ((TEMPLATE_ENTRY_EXT *)templateEntry)->subComponentList.subComponentInfo = subcomponentArray;
+
+        //Property columns and cold array from the sorted property array
+        status = buildTemplatePropertyColumns((TEMPLATE_ENTRY_EXT *)templateEntry, propertyArray);
+        if(propertyArray != NULL)
+            OSrelease(propertyArray);
+
+        if(status != OK)
+            return status;
 
         //Add component info to template structure. 
         templateEntry->templateSubComponentInfo = subcomponentHashInfo;
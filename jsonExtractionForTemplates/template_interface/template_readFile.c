@@ -31,15 +31,45 @@ Outputs:  buffer - Pointer to the buffer structure the file contains
 //tbool check if template already in cached then add only new one
 ERROR_STATUS ReadTemplateFile(TCHAR* pTemplateName, SIGNED8** buffer,UNSIGNED8 tbool)
 {
-  UNSIGNED16 jsonPathSize = 0;
   TCHAR* jsonFilePath = NULL;
-  SIGNED8 jsonFilePathForGZ[MAX_FILE_PATH] = {0}; // expects ascii for WIN32 and Unicode for target
-  SIGNED8* fileBuffer = NULL;
-  UNSIGNED32 fileSize = 0;
   ERROR_STATUS status;
+
+  status = GetTemplateFilePath(pTemplateName, &jsonFilePath, tbool);
+  if (status != OK)
+  {
+    return status;
+  }
+
+  status = ReadTemplateFileFromPath(jsonFilePath, buffer);
+
+  //Release the memory allocated for storing jsonFilePath
+  OSrelease(jsonFilePath);
+
+  return status;
+//lint -e{429}  pTemplateName being released by the callee
+}
+
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplateFilePath method
+
+Purpose:  Builds the full path of the template file from the template path
+          resource and the template name.
+
+Inputs:   pTemplateName - Name of the template json file. If NULL, the name is
+                          read from the resource selected by tbool
+          tbool - FALSE for the big template file, TRUE for the new template file
+
+Outputs:  jsonFilePath - Full path of the template file
+
+***NOTE: Caller is responsible for releasing jsonFilePath
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplateFilePath(TCHAR* pTemplateName, TCHAR** jsonFilePath, UNSIGNED8 tbool)
+{
+  UNSIGNED16 jsonPathSize = 0;
+  TCHAR* filePath = NULL;
   PARM_DATA  TemplatePathParm, TemplateParm;
   TCHAR*       pTemplatePath;
-  SIGNED8 isCompressed = 0;
 
   //Read the Template path
   oreGetMyResource(RID_DATA_MODEL_TEMPLATE_PATH, &TemplatePathParm);
@@ -76,9 +106,9 @@ ERROR_STATUS ReadTemplateFile(TCHAR* pTemplateName, SIGNED8** buffer,UNSIGNED8 t
   jsonPathSize = STR_STORE(OSstrlen(pTemplatePath) + OSstrlen(pTemplateName)); //to hold path and template name
 
   //Allocate memory to hold template file name
-  jsonFilePath  = (TCHAR*)OSacquire(jsonPathSize);
+  filePath  = (TCHAR*)OSacquire(jsonPathSize);
 
-  if (jsonFilePath == NULL)
+  if (filePath == NULL)
   {
     //Release Template Path and Template parms
     apsReleaseParm(&TemplatePathParm);
@@ -87,18 +117,44 @@ ERROR_STATUS ReadTemplateFile(TCHAR* pTemplateName, SIGNED8** buffer,UNSIGNED8 t
     return NOT_ENOUGH_MEMORY;
   }
 
-  OSmemset(jsonFilePath, 0, jsonPathSize);
+  OSmemset(filePath, 0, jsonPathSize);
 
-  //Copy to jsonFilePath
-  OSstrcpy(jsonFilePath, pTemplatePath);
+  //Copy to filePath
+  OSstrcpy(filePath, pTemplatePath);
 
   //Concatenate path with the file name
-  OSstrcat(jsonFilePath, pTemplateName);
+  OSstrcat(filePath, pTemplateName);
 
   //Release Template Path and Template parms
   apsReleaseParm(&TemplatePathParm);
   apsReleaseParm(&TemplateParm);
 
+  *jsonFilePath = filePath;
+
+  return OK;
+}
+
+
+/*------------------------------------------------------------------------------
+Module:   ReadTemplateFileFromPath method
+
+Purpose:  Validates the template file and loads it into a buffer, decompressing
+          it first if it is a .jz file.
+
+Inputs:   jsonFilePath - Full path of the template file
+
+Outputs:  buffer - Pointer to the buffer structure the file contains
+
+***NOTE: Caller is responsible for releasing buffer
+------------------------------------------------------------------------------*/
+ERROR_STATUS ReadTemplateFileFromPath(TCHAR* jsonFilePath, SIGNED8** buffer)
+{
+  SIGNED8 jsonFilePathForGZ[MAX_FILE_PATH] = {0}; // expects ascii for WIN32 and Unicode for target
+  SIGNED8* fileBuffer = NULL;
+  UNSIGNED32 fileSize = 0;
+  ERROR_STATUS status;
+  SIGNED8 isCompressed = 0;
+
   if (OSstrstr(jsonFilePath, _T(".jz")) != NULL)
   {
     isCompressed = 1;
@@ -118,8 +174,6 @@ ERROR_STATUS ReadTemplateFile(TCHAR* pTemplateName, SIGNED8** buffer,UNSIGNED8 t
   }
   else
   {
-    //Release the memory allocated for storing jsonFilePath
-    OSrelease(jsonFilePath);
     return FILE_TRANSFER_ERROR;
   }
 
@@ -145,11 +199,7 @@ ERROR_STATUS ReadTemplateFile(TCHAR* pTemplateName, SIGNED8** buffer,UNSIGNED8 t
     *buffer = fileBuffer;
   }
 
-  //Release the memory allocated for storing jsonFilePath
-  OSrelease(jsonFilePath);
-
   return status;
-//lint -e{429}  pTemplateName being released by the callee
 }
 
 
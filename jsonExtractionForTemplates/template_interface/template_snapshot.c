@@ -0,0 +1,857 @@
+/*------------------------------------------------------------------------------
+
+Module:   Template Snapshot
+
+Purpose:  Dumps the fully built template database (entries, properties, subcomponents,
+          version string) into a snapshot file keyed by the CRC of the template file,
+          and restores it on the next start when the template file is unchanged.
+          Restoring is a single sequential read of the snapshot. Strings and property
+          structures are used in place from the snapshot buffer, which is therefore
+          kept in memory for the lifetime of the database.
+
+Filename: template_snapshot.c
+
+Inputs:   Path of the template file the database was built from
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+#include <template_api.h>
+#include "template_api_private.h"
+#include <fileio.h>
+#include <uniStr.h>
+
+//Marks a NULL string in the snapshot
+#define SNAPSHOT_NULL_STRING    0xFFFF
+
+//Chunk size used while computing the CRC of the template file
+#define SNAPSHOT_CRC_CHUNK_SIZE 512
+
+//Initial size of the snapshot write buffer
+#define SNAPSHOT_WRITE_GROW_SIZE 4096
+
+typedef struct
+{
+	UNSIGNED8 * data;
+	UNSIGNED32 position;
+	UNSIGNED32 size;
+	UNSIGNED8 failed;
+} SNAPSHOT_BUFFER;
+
+static UNSIGNED32 crcTable[256];
+static UNSIGNED8 crcTableReady = FALSE;
+
+/*------------------------------------------------------------------------------
+Module:   snapshotCrcUpdate method
+
+Purpose:  Updates a running CRC-32 (IEEE 802.3, reflected) with a block of bytes.
+          The lookup table is built on first use.
+
+Inputs:   crc - Running CRC value
+          data - Bytes to add
+          length - Number of bytes
+
+Outputs:  Updated CRC value
+------------------------------------------------------------------------------*/
+static UNSIGNED32 snapshotCrcUpdate(UNSIGNED32 crc, const UNSIGNED8 * data, UNSIGNED32 length)
+{
+	UNSIGNED32 index, bit, value;
+
+	if(crcTableReady == FALSE)
+	{
+		for(index = 0; index < 256; index++)
+		{
+			value = index;
+			for(bit = 0; bit < 8; bit++)
+				value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+			crcTable[index] = value;
+		}
+		crcTableReady = TRUE;
+	}
+
+	while(length--)
+		crc = crcTable[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetTemplateFileCrc method
+
+Purpose:  Computes the CRC-32 and size of the (possibly compressed) template file.
+          This is the key a snapshot is validated against.
+
+Inputs:   jsonFilePath - Full path of the template file
+
+Outputs:  crc - CRC-32 of the file contents
+          fileSize - Size of the file in bytes
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetTemplateFileCrc(TCHAR * jsonFilePath, UNSIGNED32 * crc, UNSIGNED32 * fileSize)
+{
+	UNSIGNED8 chunk[SNAPSHOT_CRC_CHUNK_SIZE];
+	UNSIGNED32 bytesRead = 0;
+	UNSIGNED32 totalBytes = 0;
+	UNSIGNED32 crcValue = 0xFFFFFFFF;
+	TCHAR rb_filemode[] = {(TCHAR)'r', (TCHAR)'b', (TCHAR)'\0'};
+	void * pFile;
+
+	pFile = OSFileOpen(jsonFilePath, rb_filemode);
+	if(pFile == NULL)
+		return FILE_NOT_FOUND;
+
+	do
+	{
+		bytesRead = OSFileRead(chunk, sizeof(UNSIGNED8), SNAPSHOT_CRC_CHUNK_SIZE, pFile);
+		crcValue = snapshotCrcUpdate(crcValue, chunk, bytesRead);
+		totalBytes += bytesRead;
+	}
+	while(bytesRead == SNAPSHOT_CRC_CHUNK_SIZE);
+
+	OSFileClose(pFile);
+
+	*crc = crcValue ^ 0xFFFFFFFF;
+	*fileSize = totalBytes;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getSnapshotPath method
+
+Purpose:  Returns the snapshot file path for a given template file path.
+
+Inputs:   jsonFilePath - Full path of the template file
+
+Outputs:  snapshotPath - Template file path + TEMPLATE_SNAPSHOT_SUFFIX.
+                         Caller is responsible for releasing it.
+------------------------------------------------------------------------------*/
+static ERROR_STATUS getSnapshotPath(TCHAR * jsonFilePath, TCHAR ** snapshotPath)
+{
+	TCHAR * path;
+	UNSIGNED16 pathSize;
+
+	pathSize = STR_STORE(OSstrlen(jsonFilePath) + OSstrlen(TEMPLATE_SNAPSHOT_SUFFIX));
+	path = (TCHAR *)OSacquire(pathSize);
+	if(path == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	OSmemset(path, 0, pathSize);
+	OSstrcpy(path, jsonFilePath);
+	OSstrcat(path, TEMPLATE_SNAPSHOT_SUFFIX);
+
+	*snapshotPath = path;
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   Snapshot write helpers
+
+Purpose:  Append data to a growable snapshot buffer. Any allocation failure marks
+          the buffer as failed and further writes are ignored.
+------------------------------------------------------------------------------*/
+static void snapshotReserve(SNAPSHOT_BUFFER * snapshot, UNSIGNED32 length)
+{
+	UNSIGNED8 * newData;
+	UNSIGNED32 newSize;
+
+	if(snapshot->failed || snapshot->position + length <= snapshot->size)
+		return;
+
+	newSize = snapshot->size ? snapshot->size : SNAPSHOT_WRITE_GROW_SIZE;
+	while(newSize < snapshot->position + length)
+		newSize *= 2;
+
+	newData = (UNSIGNED8 *)OSacquire(newSize);
+	if(newData == NULL)
+	{
+		snapshot->failed = TRUE;
+		return;
+	}
+
+	OSmemset(newData, 0, newSize);
+	if(snapshot->data != NULL)
+	{
+		OSmemcpy(newData, snapshot->data, snapshot->position);
+		OSrelease(snapshot->data);
+	}
+	snapshot->data = newData;
+	snapshot->size = newSize;
+}
+
+static void snapshotAlign(SNAPSHOT_BUFFER * snapshot, UNSIGNED32 alignment)
+{
+	UNSIGNED32 padding = (alignment - (snapshot->position % alignment)) % alignment;
+
+	snapshotReserve(snapshot, padding);
+	if(!snapshot->failed)
+		snapshot->position += padding;
+}
+
+static void snapshotPutBytes(SNAPSHOT_BUFFER * snapshot, const void * data, UNSIGNED32 length, UNSIGNED32 alignment)
+{
+	snapshotAlign(snapshot, alignment);
+	snapshotReserve(snapshot, length);
+	if(snapshot->failed)
+		return;
+
+	OSmemcpy(snapshot->data + snapshot->position, data, length);
+	snapshot->position += length;
+}
+
+static void snapshotPutU16(SNAPSHOT_BUFFER * snapshot, UNSIGNED16 value)
+{
+	snapshotPutBytes(snapshot, &value, sizeof(value), sizeof(value));
+}
+
+static void snapshotPutString(SNAPSHOT_BUFFER * snapshot, TCHAR * string)
+{
+	UNSIGNED16 length;
+
+	if(string == NULL)
+	{
+		snapshotPutU16(snapshot, SNAPSHOT_NULL_STRING);
+		return;
+	}
+
+	//Terminator is stored so the restored string can be used in place
+	length = OSstrlen(string);
+	snapshotPutU16(snapshot, length);
+	snapshotPutBytes(snapshot, string, STR_STORE(length), sizeof(TCHAR));
+}
+
+/*------------------------------------------------------------------------------
+Module:   Snapshot read helpers
+
+Purpose:  Read data from the snapshot buffer in place. Reading past the end marks
+          the buffer as failed and returns zero/NULL.
+------------------------------------------------------------------------------*/
+static void * snapshotGetBytes(SNAPSHOT_BUFFER * snapshot, UNSIGNED32 length, UNSIGNED32 alignment)
+{
+	void * data;
+
+	snapshot->position += (alignment - (snapshot->position % alignment)) % alignment;
+	if(snapshot->failed || snapshot->position + length > snapshot->size)
+	{
+		snapshot->failed = TRUE;
+		return NULL;
+	}
+
+	data = snapshot->data + snapshot->position;
+	snapshot->position += length;
+	return data;
+}
+
+static UNSIGNED16 snapshotGetU16(SNAPSHOT_BUFFER * snapshot)
+{
+	UNSIGNED16 * value = (UNSIGNED16 *)snapshotGetBytes(snapshot, sizeof(UNSIGNED16), sizeof(UNSIGNED16));
+
+	return value ? *value : 0;
+}
+
+static TCHAR * snapshotGetString(SNAPSHOT_BUFFER * snapshot)
+{
+	UNSIGNED16 length;
+	TCHAR * string;
+
+	length = snapshotGetU16(snapshot);
+	if(length == SNAPSHOT_NULL_STRING)
+		return NULL;
+
+	string = (TCHAR *)snapshotGetBytes(snapshot, STR_STORE(length), sizeof(TCHAR));
+	if(string != NULL && string[length] != 0)
+		snapshot->failed = TRUE;
+
+	return snapshot->failed ? NULL : string;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getHashNodes method
+
+Purpose:  Collects every node of a hash table into an array (bucket order, chain
+          order within a bucket). Writing the array back to front and re-inserting
+          front to back reproduces the original chains.
+
+Inputs:   hashTable - Hash table to walk
+
+Outputs:  nodes - Array of nodes, caller releases it. NULL if the hash is empty.
+          count - Number of nodes
+------------------------------------------------------------------------------*/
+static ERROR_STATUS getHashNodes(APSHASHTBL * hashTable, struct hashEntry_s *** nodes, UNSIGNED16 * count)
+{
+	struct hashEntry_s * node;
+	struct hashEntry_s ** nodeArray = NULL;
+	UNSIGNED16 nodeCount = 0;
+	hashIndex idx;
+
+	*nodes = NULL;
+	*count = 0;
+
+	if(hashTable == NULL)
+		return OK;
+
+	for(idx = 0; idx < hashTable->size; idx++)
+		for(node = hashTable->nodes[idx]; node != NULL; node = node->next)
+			nodeCount++;
+
+	if(nodeCount == 0)
+		return OK;
+
+	nodeArray = (struct hashEntry_s **)OSacquire(sizeof(struct hashEntry_s *) * nodeCount);
+	if(nodeArray == NULL)
+		return NOT_ENOUGH_MEMORY;
+
+	nodeCount = 0;
+	for(idx = 0; idx < hashTable->size; idx++)
+		for(node = hashTable->nodes[idx]; node != NULL; node = node->next)
+			nodeArray[nodeCount++] = node;
+
+	*nodes = nodeArray;
+	*count = nodeCount;
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   snapshotPutTemplate method
+
+Purpose:  Appends one template record (entry, properties and subcomponents).
+
+Inputs:   snapshot - Snapshot write buffer
+          interfaceName - Key of the template in templateHash
+          templateNumber - Template Id (key in templateStructureHash)
+          templateEntry - Parsed template
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+static ERROR_STATUS snapshotPutTemplate(SNAPSHOT_BUFFER * snapshot, TCHAR * interfaceName, UNSIGNED16 templateNumber, TEMPLATE_ENTRY * templateEntry)
+{
+	TEMPLATE_ENTRY_EXT * entryExt = (TEMPLATE_ENTRY_EXT *)templateEntry;
+	UNSIGNED16 index;
+	TEMPLATE_SUBCOMPONENT_INFO * subcomponentInfo;
+
+	snapshotPutU16(snapshot, templateNumber);
+	snapshotPutString(snapshot, interfaceName);
+	snapshotPutU16(snapshot, templateEntry->type);
+	snapshotPutU16(snapshot, templateEntry->subType);
+	snapshotPutU16(snapshot, templateEntry->presentValueAttrId);
+	snapshotPutString(snapshot, templateEntry->templateParent);
+	snapshotPutString(snapshot, templateEntry->dictionaryName);
+	snapshotPutString(snapshot, templateEntry->templateName);
+	snapshotPutString(snapshot, templateEntry->templateDescription);
+	snapshotPutString(snapshot, templateEntry->templateID);
+
+	//Properties - the cold array and the attribute Id, data type and flag columns as raw
+	//data, restored in place. The membership filter is rebuilt on restore.
+	snapshotPutU16(snapshot, entryExt->numProperties);
+	snapshotAlign(snapshot, TEMPLATE_SNAPSHOT_ALIGN);
+	if(entryExt->numProperties > 0)
+	{
+		snapshotPutBytes(snapshot, entryExt->propertyColdInfo, sizeof(TEMPLATE_PROPERTY_COLD_INFO) * entryExt->numProperties, TEMPLATE_SNAPSHOT_ALIGN);
+		snapshotPutBytes(snapshot, entryExt->propertyAttrIds, sizeof(UNSIGNED16) * entryExt->numProperties, sizeof(UNSIGNED16));
+		snapshotPutBytes(snapshot, entryExt->propertyDataTypes, sizeof(UNSIGNED8) * entryExt->numProperties, sizeof(UNSIGNED8));
+		snapshotPutBytes(snapshot, entryExt->propertyFlags, sizeof(UNSIGNED8) * entryExt->numProperties, sizeof(UNSIGNED8));
+	}
+
+	//Subcomponents, in template file order
+	snapshotPutU16(snapshot, entryExt->subComponentList.numSubComponentInfoEntries);
+	for(index = 0; index < entryExt->subComponentList.numSubComponentInfoEntries; index++)
+	{
+		subcomponentInfo = &entryExt->subComponentList.subComponentInfo[index];
+		snapshotPutString(snapshot, subcomponentInfo->subComponentId);
+		snapshotPutString(snapshot, subcomponentInfo->templateId);
+		snapshotPutU16(snapshot, subcomponentInfo->subComponentRequired);
+		snapshotPutU16(snapshot, subcomponentInfo->subComponentSetId);
+		snapshotPutU16(snapshot, subcomponentInfo->subComponentLabelValue);
+	}
+
+	return snapshot->failed ? NOT_ENOUGH_MEMORY : OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   SaveTemplateSnapshot method
+
+Purpose:  Dumps the template database into the snapshot file of the given template
+          file. Called by InitTemplate once the template file was parsed.
+
+Inputs:   jsonFilePath - Full path of the template file the database was built from
+          sourceCrc, sourceSize - CRC and size of that template file
+          templateDb - Template database to dump
+          templateVersion - Version string of the template file
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS SaveTemplateSnapshot(TCHAR * jsonFilePath, UNSIGNED32 sourceCrc, UNSIGNED32 sourceSize, TEMPLATE_DATABASE * templateDb, TCHAR * templateVersion)
+{
+	SNAPSHOT_BUFFER snapshot;
+	TEMPLATE_SNAPSHOT_HEADER header;
+	struct hashEntry_s ** nodes = NULL;
+	UNSIGNED16 nodeCount = 0;
+	UNSIGNED16 index;
+	UNSIGNED16 templateNumber;
+	TEMPLATE_ENTRY * templateEntry;
+	TCHAR * snapshotPath = NULL;
+	TCHAR wb_filemode[] = {(TCHAR)'w', (TCHAR)'b', (TCHAR)'\0'};
+	void * pFile;
+	ERROR_STATUS status = OK;
+
+	if(templateDb == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	OSmemset(&snapshot, 0, sizeof(snapshot));
+	OSmemset(&header, 0, sizeof(header));
+
+	status = getHashNodes(templateDb->templateHash, &nodes, &nodeCount);
+	if(status != OK)
+		return status;
+
+	//Header is patched once the payload size is known
+	snapshotPutBytes(&snapshot, &header, sizeof(header), TEMPLATE_SNAPSHOT_ALIGN);
+	snapshotPutString(&snapshot, templateVersion);
+
+	for(index = nodeCount; index > 0 && status == OK; index--)
+	{
+		templateNumber = *(UNSIGNED16 *)nodes[index - 1]->data;
+
+		if(hashtbl_get(templateDb->templateStructureHash, &templateNumber, sizeof(templateNumber), (void **)&templateEntry) != OK)
+		{
+			status = TEMPLATE_NOT_FOUND;
+			break;
+		}
+
+		status = snapshotPutTemplate(&snapshot, (TCHAR *)nodes[index - 1]->key, templateNumber, templateEntry);
+	}
+
+	if(nodes != NULL)
+		OSrelease(nodes);
+
+	if(status == OK && snapshot.failed)
+		status = NOT_ENOUGH_MEMORY;
+
+	if(status == OK)
+	{
+		header.magic = TEMPLATE_SNAPSHOT_MAGIC;
+		header.snapshotVersion = TEMPLATE_SNAPSHOT_VERSION;
+		header.coldInfoSize = sizeof(TEMPLATE_PROPERTY_COLD_INFO);
+		header.sourceCrc = sourceCrc;
+		header.sourceSize = sourceSize;
+		header.payloadSize = snapshot.position - sizeof(header);
+		header.payloadCrc = snapshotCrcUpdate(0xFFFFFFFF, snapshot.data + sizeof(header), header.payloadSize) ^ 0xFFFFFFFF;
+		header.templateCount = templateDb->templateCount;
+		header.entryCount = nodeCount;
+		OSmemcpy(snapshot.data, &header, sizeof(header));
+
+		status = getSnapshotPath(jsonFilePath, &snapshotPath);
+	}
+
+	if(status == OK)
+	{
+		pFile = OSFileOpen(snapshotPath, wb_filemode);
+		if(pFile == NULL)
+		{
+			status = FILE_NOT_FOUND;
+		}
+		else
+		{
+			if(OSFileWrite(snapshot.data, sizeof(UNSIGNED8), snapshot.position, pFile) != snapshot.position)
+				status = ERROR_RESPONSE;
+
+			OSFileClose(pFile);
+		}
+
+		OSrelease(snapshotPath);
+	}
+
+	if(snapshot.data != NULL)
+		OSrelease(snapshot.data);
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   snapshotGetTemplate method
+
+Purpose:  Reads one template record. With build == FALSE the record is only
+          validated; with build == TRUE the template is inserted into the database.
+
+Inputs:   snapshot - Snapshot read buffer positioned at the record
+          templateDb - Template database to fill
+          build - FALSE to validate, TRUE to build
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+static ERROR_STATUS snapshotGetTemplate(SNAPSHOT_BUFFER * snapshot, TEMPLATE_DATABASE * templateDb, UNSIGNED8 build)
+{
+	UNSIGNED16 * templateNumber;
+	TCHAR * interfaceName;
+	TEMPLATE_ENTRY * templateEntry = NULL;
+	TEMPLATE_ENTRY entry;
+	TEMPLATE_PROPERTY_COLD_INFO * coldArray = NULL;
+	UNSIGNED16 * attrIdArray = NULL;
+	UNSIGNED8 * dataTypeArray = NULL;
+	UNSIGNED8 * flagArray = NULL;
+	TEMPLATE_SUBCOMPONENT_INFO * subcomponentArray = NULL;
+	TEMPLATE_SUBCOMPONENT_INFO subcomponent;
+	UNSIGNED16 propertyCount, subcomponentCount, index;
+	ERROR_STATUS status = OK;
+
+	OSmemset(&entry, 0, sizeof(entry));
+
+	templateNumber = (UNSIGNED16 *)snapshotGetBytes(snapshot, sizeof(UNSIGNED16), sizeof(UNSIGNED16));
+	interfaceName = snapshotGetString(snapshot);
+	entry.type = snapshotGetU16(snapshot);
+	entry.subType = snapshotGetU16(snapshot);
+	entry.presentValueAttrId = snapshotGetU16(snapshot);
+	entry.templateParent = snapshotGetString(snapshot);
+	entry.dictionaryName = snapshotGetString(snapshot);
+	entry.templateName = snapshotGetString(snapshot);
+	entry.templateDescription = snapshotGetString(snapshot);
+	entry.templateID = snapshotGetString(snapshot);
+
+	propertyCount = snapshotGetU16(snapshot);
+	snapshotGetBytes(snapshot, 0, TEMPLATE_SNAPSHOT_ALIGN);
+	if(propertyCount > 0)
+	{
+		coldArray = (TEMPLATE_PROPERTY_COLD_INFO *)snapshotGetBytes(snapshot, sizeof(TEMPLATE_PROPERTY_COLD_INFO) * propertyCount, TEMPLATE_SNAPSHOT_ALIGN);
+		attrIdArray = (UNSIGNED16 *)snapshotGetBytes(snapshot, sizeof(UNSIGNED16) * propertyCount, sizeof(UNSIGNED16));
+		dataTypeArray = (UNSIGNED8 *)snapshotGetBytes(snapshot, sizeof(UNSIGNED8) * propertyCount, sizeof(UNSIGNED8));
+		flagArray = (UNSIGNED8 *)snapshotGetBytes(snapshot, sizeof(UNSIGNED8) * propertyCount, sizeof(UNSIGNED8));
+	}
+
+	if(snapshot->failed || interfaceName == NULL)
+		return ERROR_RESPONSE;
+
+	//The lookup relies on the column being sorted by attribute Id, without duplicates
+	for(index = 1; index < propertyCount; index++)
+	{
+		if(attrIdArray[index - 1] >= attrIdArray[index])
+			return ERROR_RESPONSE;
+	}
+
+	if(build)
+	{
+		templateEntry = (TEMPLATE_ENTRY *)OSacquire(sizeof(TEMPLATE_ENTRY_EXT));
+		if(templateEntry == NULL)
+			return NOT_ENOUGH_MEMORY;
+
+		OSmemset(templateEntry, 0, sizeof(TEMPLATE_ENTRY_EXT));
+		*templateEntry = entry;
+		((TEMPLATE_ENTRY_EXT *)templateEntry)->numProperties = propertyCount;
+		((TEMPLATE_ENTRY_EXT *)templateEntry)->propertyColdInfo = coldArray;
+		((TEMPLATE_ENTRY_EXT *)templateEntry)->propertyAttrIds = attrIdArray;
+		((TEMPLATE_ENTRY_EXT *)templateEntry)->propertyDataTypes = dataTypeArray;
+		((TEMPLATE_ENTRY_EXT *)templateEntry)->propertyFlags = flagArray;
+
+		//Inserted first, so a failure below leaves it to discardSnapshotTemplates
+		status = hashtbl_insert(templateDb->templateStructureHash, templateNumber, templateEntry, sizeof(*templateNumber));
+		if(status != OK)
+		{
+			OSrelease(templateEntry);
+			return status;
+		}
+
+		status = buildTemplateMembershipFilter((TEMPLATE_ENTRY_EXT *)templateEntry);
+		if(status != OK)
+			return status;
+
+		//Filled with the property records when they are first asked for
+		if(!(templateEntry->templateAttrInfo = hashtbl_create(TEMPLATE_PROPERTY_DB_ENTRY_GROW_SIZE, HASH_TYPE_INT)))
+			return HASH_CREATE_ERROR;
+
+		if(!(templateEntry->templateSubComponentInfo = hashtbl_create(TEMPLATE_COMPONENT_DB_ENTRY_GROW_SIZE, HASH_TYPE_STR)))
+			return HASH_CREATE_ERROR;
+	}
+
+	subcomponentCount = snapshotGetU16(snapshot);
+	if(build && subcomponentCount > 0)
+	{
+		subcomponentArray = (TEMPLATE_SUBCOMPONENT_INFO *)OSacquire(sizeof(TEMPLATE_SUBCOMPONENT_INFO) * subcomponentCount);
+		if(subcomponentArray == NULL)
+			return NOT_ENOUGH_MEMORY;
+		OSmemset(subcomponentArray, 0, sizeof(TEMPLATE_SUBCOMPONENT_INFO) * subcomponentCount);
+		((TEMPLATE_ENTRY_EXT *)templateEntry)->subComponentList.subComponentInfo = subcomponentArray;
+	}
+
+	for(index = 0; index < subcomponentCount; index++)
+	{
+		OSmemset(&subcomponent, 0, sizeof(subcomponent));
+		subcomponent.subComponentId = snapshotGetString(snapshot);
+		subcomponent.templateId = snapshotGetString(snapshot);
+		subcomponent.subComponentRequired = (UNSIGNED8)snapshotGetU16(snapshot);
+		subcomponent.subComponentSetId = snapshotGetU16(snapshot);
+		subcomponent.subComponentLabelValue = snapshotGetU16(snapshot);
+
+		if(snapshot->failed || subcomponent.subComponentId == NULL)
+			return ERROR_RESPONSE;
+
+		if(build)
+		{
+			subcomponentArray[index] = subcomponent;
+			status = hashtbl_insert(templateEntry->templateSubComponentInfo, subcomponentArray[index].subComponentId, &subcomponentArray[index], STR_STORE(OSstrlen(subcomponentArray[index].subComponentId)));
+			if(status != OK)
+				return status;
+		}
+	}
+
+	if(build)
+	{
+		((TEMPLATE_ENTRY_EXT *)templateEntry)->subComponentList.numSubComponentInfoEntries = subcomponentCount;
+
+		status = hashtbl_insert(templateDb->templateHash, interfaceName, templateNumber, STR_STORE(OSstrlen(interfaceName)));
+		if(status != OK)
+			return status;
+
+		status = MarkTemplateAdded(templateDb, *templateNumber);
+		if(status != OK)
+			return status;
+
+		status = IndexTemplateReferences(templateDb, *templateNumber);
+	}
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   releaseSnapshotEntry method
+
+Purpose:  Releases a template entry built from the snapshot. Its strings and property
+          columns live in the snapshot buffer and are not released here.
+
+Inputs:   entryExt - Template entry (allocated as TEMPLATE_ENTRY_EXT)
+
+Outputs:  None.
+------------------------------------------------------------------------------*/
+static void releaseSnapshotEntry(TEMPLATE_ENTRY_EXT * entryExt)
+{
+	if(entryExt->entry.templateAttrInfo != NULL)
+		hashtbl_destroy(entryExt->entry.templateAttrInfo);
+
+	if(entryExt->entry.templateSubComponentInfo != NULL)
+		hashtbl_destroy(entryExt->entry.templateSubComponentInfo);
+
+	if(entryExt->propertyList.propertyInfo != NULL)
+		OSrelease(entryExt->propertyList.propertyInfo);
+
+	if(entryExt->membership.bits != NULL)
+		OSrelease(entryExt->membership.bits);
+
+	if(entryExt->subComponentList.subComponentInfo != NULL)
+		OSrelease(entryExt->subComponentList.subComponentInfo);
+
+	if(entryExt->resolvedInfo.propertyInfo != NULL)
+		OSrelease(entryExt->resolvedInfo.propertyInfo);
+
+	if(entryExt->resolvedInfo.subComponentInfo != NULL)
+		OSrelease(entryExt->resolvedInfo.subComponentInfo);
+
+	OSrelease(entryExt);
+}
+
+/*------------------------------------------------------------------------------
+Module:   releasePostingLists method
+
+Purpose:  Releases a reverse index hash and the posting lists it holds.
+
+Inputs:   indexHash - Reverse index hash, may be NULL
+
+Outputs:  None.
+------------------------------------------------------------------------------*/
+static void releasePostingLists(APSHASHTBL * indexHash)
+{
+	struct hashEntry_s * node;
+	TEMPLATE_POSTING_LIST * postingList;
+	hashIndex idx;
+
+	if(indexHash == NULL)
+		return;
+
+	for(idx = 0; idx < indexHash->size; idx++)
+	{
+		for(node = indexHash->nodes[idx]; node != NULL; node = node->next)
+		{
+			postingList = (TEMPLATE_POSTING_LIST *)node->data;
+			if(postingList->templateIds != NULL)
+				OSrelease(postingList->templateIds);
+			OSrelease(postingList);
+		}
+	}
+
+	hashtbl_destroy(indexHash);
+}
+
+/*------------------------------------------------------------------------------
+Module:   discardSnapshotTemplates method
+
+Purpose:  Undoes a build pass that failed part way: releases every template inserted
+          from the snapshot and the reverse indexes, and replaces the template hashes
+          with empty ones, so the database is as empty as before the restore.
+
+Inputs:   templateDb - Template database being restored
+
+Outputs:  ERROR_STATUS - HASH_CREATE_ERROR if the empty hashes can't be created
+------------------------------------------------------------------------------*/
+static ERROR_STATUS discardSnapshotTemplates(TEMPLATE_DATABASE * templateDb)
+{
+	TEMPLATE_DATABASE_EXT * templateDbExt = (TEMPLATE_DATABASE_EXT *)templateDb;
+	struct hashEntry_s * node;
+	hashIndex idx;
+
+	for(idx = 0; idx < templateDb->templateStructureHash->size; idx++)
+		for(node = templateDb->templateStructureHash->nodes[idx]; node != NULL; node = node->next)
+			releaseSnapshotEntry((TEMPLATE_ENTRY_EXT *)node->data);
+
+	releasePostingLists(templateDbExt->propertyTemplatesHash);
+	releasePostingLists(templateDbExt->subComponentParentsHash);
+	releasePostingLists(templateDbExt->extendingTemplatesHash);
+	templateDbExt->propertyTemplatesHash = NULL;
+	templateDbExt->subComponentParentsHash = NULL;
+	templateDbExt->extendingTemplatesHash = NULL;
+
+	//templateHash data points into the snapshot buffer, only the nodes are released
+	hashtbl_destroy(templateDb->templateHash);
+	hashtbl_destroy(templateDb->templateStructureHash);
+	templateDb->templateCount = 0;
+
+	//The templates are gone from the export
+	templateDbExt->generation++;
+	ReleaseTemplateExportCache(templateDb);
+
+	if((templateDb->templateHash = hashtbl_create(TEMPLATE_DB_ENTRY_GROW_SIZE, HASH_TYPE_STR)) == NULL)
+		return HASH_CREATE_ERROR;
+
+	if((templateDb->templateStructureHash = hashtbl_create(TEMPLATE_DB_ENTRY_GROW_SIZE, HASH_TYPE_INT)) == NULL)
+		return HASH_CREATE_ERROR;
+
+	return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   snapshotWalk method
+
+Purpose:  Reads the version string and every template record of the snapshot
+          payload, validating (build == FALSE) or building (build == TRUE).
+
+Inputs:   snapshot - Snapshot read buffer holding header and payload
+          entryCount - Number of template records
+          templateDb - Template database to fill
+          build - FALSE to validate, TRUE to build
+
+Outputs:  templateVersion - Version string, in place in the snapshot buffer
+------------------------------------------------------------------------------*/
+static ERROR_STATUS snapshotWalk(SNAPSHOT_BUFFER * snapshot, UNSIGNED16 entryCount, TEMPLATE_DATABASE * templateDb, UNSIGNED8 build, TCHAR ** templateVersion)
+{
+	UNSIGNED16 index;
+	ERROR_STATUS status = OK;
+
+	snapshot->position = sizeof(TEMPLATE_SNAPSHOT_HEADER);
+	*templateVersion = snapshotGetString(snapshot);
+
+	for(index = 0; index < entryCount && status == OK; index++)
+		status = snapshotGetTemplate(snapshot, templateDb, build);
+
+	if(status == OK && (snapshot->failed || snapshot->position != snapshot->size))
+		status = ERROR_RESPONSE;
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   RestoreTemplateSnapshot method
+
+Purpose:  Restores the template database from the snapshot of the given template
+          file, if the snapshot was built by this firmware from a template file
+          with the same CRC and size. The payload is checked against its CRC and
+          the whole snapshot is validated before the database is touched, and a
+          build that fails part way is discarded, so on any failure the database
+          is left empty.
+
+Inputs:   jsonFilePath - Full path of the template file
+          sourceCrc, sourceSize - CRC and size of that template file
+          templateDb - Empty template database to fill
+
+Outputs:  templateVersion - Version string of the template file
+          Returns OK if the database was restored, NOT_ENOUGH_MEMORY if it ran out
+          of memory while restoring, HASH_CREATE_ERROR if the emptied database
+          could not be set up again, any other status if the snapshot is unusable.
+------------------------------------------------------------------------------*/
+ERROR_STATUS RestoreTemplateSnapshot(TCHAR * jsonFilePath, UNSIGNED32 sourceCrc, UNSIGNED32 sourceSize, TEMPLATE_DATABASE * templateDb, TCHAR ** templateVersion)
+{
+	SNAPSHOT_BUFFER snapshot;
+	TEMPLATE_SNAPSHOT_HEADER header;
+	TCHAR * snapshotPath = NULL;
+	TCHAR * version;
+	TCHAR rb_filemode[] = {(TCHAR)'r', (TCHAR)'b', (TCHAR)'\0'};
+	void * pFile;
+	ERROR_STATUS status;
+
+	if(templateDb == NULL)
+		return TEMPLATE_DATABASE_NOT_FOUND;
+
+	status = getSnapshotPath(jsonFilePath, &snapshotPath);
+	if(status != OK)
+		return status;
+
+	pFile = OSFileOpen(snapshotPath, rb_filemode);
+	OSrelease(snapshotPath);
+
+	if(pFile == NULL)
+		return FILE_NOT_FOUND;
+
+	//Check the key before reading the payload
+	if(OSFileRead(&header, sizeof(UNSIGNED8), sizeof(header), pFile) != sizeof(header) ||
+		header.magic != TEMPLATE_SNAPSHOT_MAGIC ||
+		header.snapshotVersion != TEMPLATE_SNAPSHOT_VERSION ||
+		header.coldInfoSize != sizeof(TEMPLATE_PROPERTY_COLD_INFO) ||
+		header.sourceCrc != sourceCrc ||
+		header.sourceSize != sourceSize)
+	{
+		OSFileClose(pFile);
+		return ERROR_RESPONSE;
+	}
+
+	OSmemset(&snapshot, 0, sizeof(snapshot));
+	snapshot.size = sizeof(header) + header.payloadSize;
+	snapshot.data = (UNSIGNED8 *)OSacquire(snapshot.size);
+	if(snapshot.data == NULL)
+	{
+		OSFileClose(pFile);
+		return NOT_ENOUGH_MEMORY;
+	}
+
+	OSmemcpy(snapshot.data, &header, sizeof(header));
+	if(OSFileRead(snapshot.data + sizeof(header), sizeof(UNSIGNED8), header.payloadSize, pFile) != header.payloadSize)
+		status = ERROR_RESPONSE;
+
+	//A damaged payload can still look well formed, check it before walking it
+	if(status == OK &&
+		(snapshotCrcUpdate(0xFFFFFFFF, snapshot.data + sizeof(header), header.payloadSize) ^ 0xFFFFFFFF) != header.payloadCrc)
+		status = ERROR_RESPONSE;
+
+	OSFileClose(pFile);
+
+	//First pass only validates the records so a bad snapshot leaves the database empty
+	if(status == OK)
+		status = snapshotWalk(&snapshot, header.entryCount, templateDb, FALSE, &version);
+
+	if(status != OK)
+	{
+		OSrelease(snapshot.data);
+		return status;
+	}
+
+	//Second pass builds the database, using the buffer in place. It can still run out
+	//of memory part way, the templates built so far are then discarded so the caller
+	//can fall back to the template file with an empty database.
+	status = snapshotWalk(&snapshot, header.entryCount, templateDb, TRUE, &version);
+	if(status != OK)
+	{
+		if(discardSnapshotTemplates(templateDb) != OK)
+			status = HASH_CREATE_ERROR;
+
+		OSrelease(snapshot.data);
+		return status;
+	}
+
+	templateDb->templateCount = header.templateCount;
+	*templateVersion = version;
+
+	//snapshot.data stays in memory, the database uses it in place
+	return OK;
+}
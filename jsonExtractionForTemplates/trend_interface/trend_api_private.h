@@ -17,6 +17,18 @@ ERROR_STATUS ReadTrendTemplateFile(TCHAR * pTemplateName, SIGNED8 ** buffer);
 ERROR_STATUS AddTrendTemplateToHash(TCHAR * interfaceName, json_t * jsonTemplate, TREND_DATABASE * trendDb);
 ERROR_STATUS loadTrendDataModelFile(TCHAR * jsonTemplatePath, SIGNED8 ** fileOutputBuffer);
 
+//Every trend template entry in trendStructureHash is allocated as TREND_TEMPLATE_ENTRY_EXT,
+//the TREND_TEMPLATE_ENTRY must stay the first member so the entry pointers can be cast to it.
+//The trend creation properties are held in one array (propertyList), trendCreationAttrInfo
+//points into it. GetTrendTemplateKeyPropertyAttributes hands out the list itself without
+//allocating, as the template list getters do: it is owned by the trend database,
+//read-only for the caller and never released by it.
+typedef struct
+{
+	TREND_TEMPLATE_ENTRY entry;
+	TREND_TEMPLATE_PROPERTY_ATTR_INFOLIST propertyList;
+} TREND_TEMPLATE_ENTRY_EXT;
+
 
 
 #endif
@@ -118,63 +118,23 @@ attribute Id list
 Inputs:   Template Id key from which the template Information needs to be retrieved
 from hash
 
-Outputs:  Pointer to Template's key property attributes list.
+Outputs:  Pointer to Template's key property attributes list. The list is built at parse
+time and owned by the trend database; it is read-only for the caller and must not be
+released.
 ------------------------------------------------------------------------------*/
 ERROR_STATUS  GetTrendTemplateKeyPropertyAttributes (UNSIGNED16 trendTemplateId,TREND_TEMPLATE_PROPERTY_ATTR_INFOLIST** trendTemplateKeyPropertiesVal)
 {
-		TREND_TEMPLATE_ENTRY * trendTemplateInfo = NULL;
-		TREND_TEMPLATE_PROPERTY_ATTR_INFOLIST *trendTemplateKeyProperties;
-		TREND_TEMPLATE_PROPERTY_ATTR_INFO  *trendTemplateKeyProperty;
-		TREND_TEMPLATE_PROPERTY_ATTR_INFO  *trendTemplateKeyProperty1;
-		ERROR_STATUS errorStatus;
-		struct hashEntry_s *node;
-		APSHASHTBL *mainnodes;
-		UNSIGNED16 index=0;
-		UNSIGNED16 attIdCount=0;
-		UNSIGNED16 totalAttributesCounts=0;
-		void *data =NULL;
+	TREND_TEMPLATE_ENTRY * trendTemplateInfo = NULL;
+	ERROR_STATUS errorStatus;
+
 	errorStatus = getTrendTemplateInfo(trendTemplateId, &trendTemplateInfo);
-		if(!errorStatus)
-		{
-			mainnodes =trendTemplateInfo->trendCreationAttrInfo;
-			for(index=0;index < 8 ; index++)
-			{
-				//Get the template present value attribute
-				node = mainnodes->nodes[index];
-				while(node)
-				{
-					//*data = node->data;
-					totalAttributesCounts = totalAttributesCounts +1;
-					node=node->next;
-				}
-			}
-			//Allocate memory for template Key Properties
-		trendTemplateKeyProperties = (TREND_TEMPLATE_PROPERTY_ATTR_INFOLIST *)OSacquire(sizeof(TREND_TEMPLATE_PROPERTY_ATTR_INFOLIST));
-			//Allocate memory for template Key Properties
-			trendTemplateKeyProperty = (TREND_TEMPLATE_PROPERTY_ATTR_INFO *)OSacquire(sizeof(TREND_TEMPLATE_PROPERTY_ATTR_INFO) * totalAttributesCounts);
-				mainnodes =trendTemplateInfo->trendCreationAttrInfo;
-				for(index=0;index < 8 ; index++)
-				{
-					//Get the template present value attribute
-					node = mainnodes->nodes[index];
-					while(node)
-					{
-						data= (void **)node->data;
-						trendTemplateKeyProperty1=(TREND_TEMPLATE_PROPERTY_ATTR_INFO *)node->data;
-						trendTemplateKeyProperty[attIdCount]=*(TREND_TEMPLATE_PROPERTY_ATTR_INFO *)node->data;// *templateKeyProperty1;
-						attIdCount++;
-						node=node->next;
-					}
-				}
-				trendTemplateKeyProperties->numtemplatePropertyInfoEntries=totalAttributesCounts;
-				trendTemplateKeyProperties->propertyInfo=trendTemplateKeyProperty;
-				*trendTemplateKeyPropertiesVal=trendTemplateKeyProperties;
-			return OK;
-
-		}
+	if(!errorStatus)
+	{
+		*trendTemplateKeyPropertiesVal = &((TREND_TEMPLATE_ENTRY_EXT *)trendTemplateInfo)->propertyList;
+		return OK;
+	}
 	return errorStatus;
 	//No need for Release - 1
-//	return OK;
 }
 
 
@@ -93,6 +93,9 @@ ERROR_STATUS trendTemplateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, U
     UNSIGNED32 propertyCount;
     UNSIGNED32 temp;
 
+    TREND_TEMPLATE_PROPERTY_ATTR_INFO * propertyArray = NULL;
+    UNSIGNED16 numProperties = 0;
+
     if(jsonTemplate != NULL)
     {
         //Create attribute and subcomponent hash
@@ -102,7 +105,10 @@ ERROR_STATUS trendTemplateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, U
 
      
         //Allocate memory for template entry
-        templateEntry = (TREND_TEMPLATE_ENTRY *)OSacquire(sizeof(TREND_TEMPLATE_ENTRY));
+        templateEntry = (TREND_TEMPLATE_ENTRY *)OSacquire(sizeof(TREND_TEMPLATE_ENTRY_EXT));
+        if(templateEntry == NULL)
+            return NOT_ENOUGH_MEMORY;
+        OSmemset(templateEntry, 0, sizeof(TREND_TEMPLATE_ENTRY_EXT));
 
         //Iterate through template properties
         iter = json_object_iter(jsonTemplate);
@@ -230,11 +236,22 @@ ERROR_STATUS trendTemplateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, U
                     //Get the number of properties associated.
                     propertyCount = json_array_size(jsonPropertyArray);	
 
+                    //All properties of the trend template are held in one array, in file order
+                    if(propertyCount > 0)
+                    {
+                        propertyArray = (TREND_TEMPLATE_PROPERTY_ATTR_INFO *)OSacquire(sizeof(TREND_TEMPLATE_PROPERTY_ATTR_INFO) * propertyCount);
+                        if(propertyArray == NULL)
+                            return NOT_ENOUGH_MEMORY;
+
+                        OSmemset(propertyArray, 0, sizeof(TREND_TEMPLATE_PROPERTY_ATTR_INFO) * propertyCount);
+                        numProperties = (UNSIGNED16)propertyCount;
+                    }
+
                     //Loop through the array
                     for(temp = 0; temp < propertyCount; temp++)
                     {
-                        //Allocate space for property structure
-                        propertyAttributeInfo = (TREND_TEMPLATE_PROPERTY_ATTR_INFO *)OSacquire(sizeof(TREND_TEMPLATE_PROPERTY_ATTR_INFO));
+                        //Property structure within the trend template's array
+                        propertyAttributeInfo = &propertyArray[temp];
 
                         //initialize the enumSet to be FALSETRUE_ENUM_SET as default - to be used for bool and enum types 
                         propertyAttributeInfo->enumSet = FALSETRUE_ENUM_SET;
@@ -282,6 +299,8 @@ ERROR_STATUS trendTemplateParse(APSHASHTBL * hashTable, json_t * jsonTemplate, U
 
         //Add property info to template structure
         templateEntry->trendCreationAttrInfo = attributeHashInfo;
+        ((TREND_TEMPLATE_ENTRY_EXT *)templateEntry)->propertyList.numtemplatePropertyInfoEntries = numProperties;
+        ((TREND_TEMPLATE_ENTRY_EXT *)templateEntry)->propertyList.propertyInfo = propertyArray;
 
         //Add component info to template structure. 
       //  templateEntry->trendTemplateSubComponentInfo = subcomponentHashInfo;
@@ -0,0 +1,791 @@
+/*------------------------------------------------------------------------------
+
+Module:   View Interface
+
+Purpose:  Builds the MenuGroup tree of a view. The tree is sized from the JSON view
+          first, then every MenuGroup of the view is laid out in one block in the order
+          the local UI walks it (group, then its child groups depth first).
+          Groups are looked up by handle through a dense array, handles are assigned
+          sequentially from 1000 so only explicit group ids need a side map.
+
+Filename: view_build.c
+
+          The views are only recorded at initialization and built on first use.
+
+Inputs:   JSON view data and the item reference of the equipment
+
+Outputs:  VIEW_EQUIPMENT_INFO_EXT of every view, inserted into viewHash
+------------------------------------------------------------------------------*/
+#include <view_api.h>
+#include "view_api_private.h"
+#include "view_ext_private.h"
+
+//State shared by the passes over one view
+typedef struct
+{
+    UNSIGNED8 * groupBlock;
+    UNSIGNED32 groupBytes;          //Bytes used by the MenuGroups so far
+    UNSIGNED32 * groupOffsets;
+    UNSIGNED16 numGroups;
+    UNSIGNED32 legacyBytes;
+    UNSIGNED16 nextHandle;          //Next handle for a group without an explicit "id"
+    MenuGroup ** groupsByHandle;
+    UNSIGNED16 numHandles;          //Groups numbered sequentially (top level group included)
+    VIEW_EXPLICIT_GROUP * explicitGroups;
+    UNSIGNED16 numExplicitGroups;   //Groups with an explicit "id"
+    TCHAR * itemReference;
+    VIEW_OID_BATCH * oidBatch;
+} VIEW_GROUP_BUILDER;
+
+//Views built by one task
+typedef struct
+{
+    TCHAR * itemReference;
+    UNSIGNED16 firstView;
+    UNSIGNED16 numViews;
+    VIEW_EQUIPMENT_INFO_EXT ** views;   //Shared by all tasks, each writes its own range
+    VIEW_OID_BATCH oidBatch;
+    ERROR_STATUS status;
+} VIEW_BUILD_PARTITION;
+
+/*------------------------------------------------------------------------------
+Module:   sizeViewGroup method
+
+Purpose:  First pass. Counts the groups under jsonGroupData (itself included) and the
+          bytes they take in the group block and took as separate allocations.
+
+Inputs:   jsonGroupData - json Object of the group (or of the view for the top level)
+
+Outputs:  builder - numGroups, groupBytes, legacyBytes, numHandles and
+                    numExplicitGroups are accumulated
+------------------------------------------------------------------------------*/
+static ERROR_STATUS sizeViewGroup(json_t * jsonGroupData, VIEW_GROUP_BUILDER * builder)
+{
+    ERROR_STATUS status;
+    json_t *jsonElementArray, *jsonGrpElementObj, *jsonGrpIdObj;
+    UNSIGNED16 elementsCount, temp;
+    UNSIGNED8 elementType;
+
+    status = getGroupElementTypeCountAndElements(jsonGroupData, &elementType, &elementsCount, &jsonElementArray);
+    if(status != OK)
+        return status;
+
+    if(builder->numGroups == (UNSIGNED16)NONE_FFFF)
+        return ERROR_RESPONSE;
+
+    builder->numGroups++;
+    builder->groupBytes += VIEW_MENU_GROUP_SIZE(elementsCount);
+    builder->legacyBytes += VIEW_LEGACY_MENU_GROUP_SIZE(elementsCount);
+
+    if(elementType == GROUP_ELEMENT_TYPE)
+    {
+        for(temp = 0; temp < elementsCount; temp++)
+        {
+            jsonGrpElementObj = json_array_get(jsonElementArray, temp);
+            if(jsonGrpElementObj == NULL)
+                return ERROR_RESPONSE;
+
+            getJSONObjectForKey(jsonGrpElementObj, _T("id"), &jsonGrpIdObj);
+            if(jsonGrpIdObj != NULL)
+                builder->numExplicitGroups++;
+            else
+                builder->numHandles++;
+
+            status = sizeViewGroup(jsonGrpElementObj, builder);
+            if(status != OK)
+                return status;
+        }
+    }
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   indexViewGroup method
+
+Purpose:  Makes a placed MenuGroup reachable by its handle. Handles in the sequential
+          range go to the dense array, any other handle to the sorted explicit groups.
+          The first group placed with a handle keeps it, as it did with the group hash.
+
+Inputs:   menuGroup - placed MenuGroup
+
+Outputs:  builder - groupsByHandle or explicitGroups updated
+------------------------------------------------------------------------------*/
+static void indexViewGroup(VIEW_GROUP_BUILDER * builder, MenuGroup * menuGroup)
+{
+    UNSIGNED16 index, temp;
+
+    index = (UNSIGNED16)(menuGroup->GroupHandle - VIEW_TOP_LEVEL_GROUP_HANDLE);
+    if(menuGroup->GroupHandle >= VIEW_TOP_LEVEL_GROUP_HANDLE && index < builder->numHandles)
+    {
+        if(builder->groupsByHandle[index] == NULL)
+            builder->groupsByHandle[index] = menuGroup;
+        return;
+    }
+
+    //Find the insert position, explicit ids are few so a shift is cheap
+    for(index = 0; index < builder->numExplicitGroups; index++)
+    {
+        if(builder->explicitGroups[index].groupHandle == menuGroup->GroupHandle)
+            return;
+        if(builder->explicitGroups[index].groupHandle > menuGroup->GroupHandle)
+            break;
+    }
+
+    for(temp = builder->numExplicitGroups; temp > index; temp--)
+        builder->explicitGroups[temp] = builder->explicitGroups[temp - 1];
+
+    builder->explicitGroups[index].groupHandle = menuGroup->GroupHandle;
+    builder->explicitGroups[index].menuGroup = menuGroup;
+    builder->numExplicitGroups++;
+}
+
+/*------------------------------------------------------------------------------
+Module:   placeViewGroup method
+
+Purpose:  Second pass. Places the MenuGroup of jsonGroupData at the next free offset of
+          the group block, fills its elements and recurses into its child groups.
+          Handles are assigned in the same order InitializeView always did: the child's
+          explicit "id" if it has one, else the next sequential handle.
+
+Inputs:   jsonGroupData - json Object of the group (or of the view for the top level)
+          groupHandle - Handle of this group
+
+Outputs:  menuGroup - The placed MenuGroup
+------------------------------------------------------------------------------*/
+static ERROR_STATUS placeViewGroup(json_t * jsonGroupData, UNSIGNED16 groupHandle, VIEW_GROUP_BUILDER * builder, MenuGroup ** menuGroup)
+{
+    ERROR_STATUS status;
+    json_t *jsonElementArray, *jsonGrpElementObj, *jsonGrpIdObj;
+    UNSIGNED16 elementsCount, temp, childHandle;
+    UNSIGNED8 elementType;
+    MenuGroup * newmenuGroup, * childGroup;
+
+    status = getGroupElementTypeCountAndElements(jsonGroupData, &elementType, &elementsCount, &jsonElementArray);
+    if(status != OK)
+        return status;
+
+    //Step - 1: Take the next slot of the block
+    newmenuGroup = (MenuGroup *)(builder->groupBlock + builder->groupBytes);
+    builder->groupOffsets[builder->numGroups++] = builder->groupBytes;
+    builder->groupBytes += VIEW_MENU_GROUP_SIZE(elementsCount);
+
+    newmenuGroup->ElementType = elementType;
+    newmenuGroup->GroupHandle = groupHandle;
+    newmenuGroup->Count = elementsCount;
+
+    //Step - 2: Index by group handle
+    indexViewGroup(builder, newmenuGroup);
+
+    *menuGroup = newmenuGroup;
+
+    //Step - 3: Fill the elements
+    if(elementType == VALUE_ELEMENT_TYPE)
+        return FillMenuDataPointsDeferred(jsonElementArray, newmenuGroup, elementsCount, builder->itemReference, builder->oidBatch);
+
+    for(temp = 0; temp < elementsCount; temp++)
+    {
+        jsonGrpElementObj = json_array_get(jsonElementArray, temp);
+        if(jsonGrpElementObj == NULL)
+            return ERROR_RESPONSE;
+
+        status = FillMenuGroupPointer(newmenuGroup, jsonGrpElementObj, temp, builder->nextHandle, builder->itemReference, builder->oidBatch);
+        if(status != OK)
+            return status;
+
+        //An explicit group id does not use up a sequential handle
+        childHandle = newmenuGroup->groupElements[temp].Group.GroupHandle;
+        getJSONObjectForKey(jsonGrpElementObj, _T("id"), &jsonGrpIdObj);
+        if(jsonGrpIdObj == NULL)
+            builder->nextHandle++;
+
+        status = placeViewGroup(jsonGrpElementObj, childHandle, builder, &childGroup);
+        if(status != OK)
+            return status;
+    }
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   BuildViewGroups method
+
+Purpose:  Builds all the MenuGroups of one view into a single block. The block holds
+          the MenuGroups in layout order, the handle index, the explicit groups and
+          the offset of every MenuGroup, in that order.
+          viewGrpHash is no longer filled, groups are found through FindViewGroup.
+          Object references are only recorded in oidBatch, the ObjectOID fields are
+          filled when the caller resolves the batch. On error the block is released
+          and nothing is left in viewInfoExt.
+
+Inputs:   jsonViewData - json Object of the view
+          itemReference - Item reference of the equipment (needed to resolve oids)
+          oidBatch - Batch collecting the object references of the views, released
+                     by the caller whatever the status
+
+Outputs:  viewInfoExt - toplevelGroup, the group block and the handle index are filled
+------------------------------------------------------------------------------*/
+ERROR_STATUS BuildViewGroups(json_t * jsonViewData, TCHAR * itemReference, VIEW_OID_BATCH * oidBatch, VIEW_EQUIPMENT_INFO_EXT * viewInfoExt)
+{
+    ERROR_STATUS status;
+    VIEW_GROUP_BUILDER builder;
+    UNSIGNED32 blockSize;
+    MenuGroup * menuGroup = NULL;
+
+    OSmemset(&builder, 0, sizeof(builder));
+
+    //Pass - 1: Size the whole view, the top level group takes the first handle
+    builder.numHandles = 1;
+    status = sizeViewGroup(jsonViewData, &builder);
+    if(status != OK)
+        return status;
+
+    //Sequential handles must fit in a group handle
+    if(builder.numHandles > (UNSIGNED16)NONE_FFFF - VIEW_TOP_LEVEL_GROUP_HANDLE)
+        return ERROR_RESPONSE;
+
+    blockSize = builder.groupBytes + builder.numHandles * sizeof(MenuGroup *) +
+                builder.numExplicitGroups * sizeof(VIEW_EXPLICIT_GROUP) + builder.numGroups * sizeof(UNSIGNED32);
+
+    builder.groupBlock = (UNSIGNED8 *)OSacquire(blockSize);
+    if(builder.groupBlock == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    OSmemset(builder.groupBlock, 0, blockSize);
+
+    //Tables follow the groups, groupBytes is a multiple of VIEW_GROUP_BLOCK_ALIGN
+    builder.groupsByHandle = (MenuGroup **)(builder.groupBlock + builder.groupBytes);
+    builder.explicitGroups = (VIEW_EXPLICIT_GROUP *)(builder.groupsByHandle + builder.numHandles);
+    builder.groupOffsets = (UNSIGNED32 *)(builder.explicitGroups + builder.numExplicitGroups);
+
+    //Pass - 2: Lay out the groups, top level group first
+    builder.groupBytes = 0;
+    builder.numGroups = 0;
+    builder.numExplicitGroups = 0;
+    builder.nextHandle = VIEW_TOP_LEVEL_GROUP_HANDLE + 1;
+    builder.itemReference = itemReference;
+    builder.oidBatch = oidBatch;
+
+    status = placeViewGroup(jsonViewData, VIEW_TOP_LEVEL_GROUP_HANDLE, &builder, &menuGroup);
+    if(status != OK)
+    {
+        OSrelease(builder.groupBlock);
+        return status;
+    }
+
+    viewInfoExt->info.toplevelGroup = menuGroup;
+    viewInfoExt->info.viewGrpHash = NULL;
+    viewInfoExt->groupBlock = builder.groupBlock;
+    viewInfoExt->groupBlockSize = blockSize;
+    viewInfoExt->groupOffsets = builder.groupOffsets;
+    viewInfoExt->numGroups = builder.numGroups;
+    viewInfoExt->legacyBytes = builder.legacyBytes;
+    viewInfoExt->groupsByHandle = builder.groupsByHandle;
+    viewInfoExt->numHandles = builder.numHandles;
+    viewInfoExt->explicitGroups = builder.explicitGroups;
+    viewInfoExt->numExplicitGroups = builder.numExplicitGroups;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   buildView method
+
+Purpose:  Builds the MenuGroups of one view. When the build fails the fields it
+          recorded in oidBatch are dropped again, they point into the released
+          block; the references themselves stay and are resolved for nothing.
+
+Inputs:   viewInfoExt - recorded view
+          itemReference - Item reference of the equipment
+          oidBatch - Batch collecting the object references of the views
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+static ERROR_STATUS buildView(VIEW_EQUIPMENT_INFO_EXT * viewInfoExt, TCHAR * itemReference, VIEW_OID_BATCH * oidBatch)
+{
+    UNSIGNED32 firstSlot = oidBatch->numSlots;
+    ERROR_STATUS status;
+
+    status = BuildViewGroups(viewInfoExt->jsonViewData, itemReference, oidBatch, viewInfoExt);
+    if(status != OK)
+        oidBatch->numSlots = firstSlot;
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   recordView method
+
+Purpose:  Records one view without building it: its equipment type data, viewId,
+          internal flag and its JSON view.
+
+Inputs:   jsonObject - json Object of the view file (equipment type data)
+          jsonViewData - json Object of the view
+
+Outputs:  viewInfoExt - the recorded view, the JSON view is not referenced yet
+------------------------------------------------------------------------------*/
+static ERROR_STATUS recordView(json_t * jsonObject, json_t * jsonViewData, VIEW_EQUIPMENT_INFO_EXT ** viewInfoExt)
+{
+    json_t *jsonViewId, *jsonTempObj;
+    VIEW_EQUIPMENT_INFO_EXT * newViewInfoExt;
+    VIEW_EQUIPMENT_INFO * viewInfo;
+
+    //Step - 1: Allocate ViewEquipmentInfo structure
+    newViewInfoExt = (VIEW_EQUIPMENT_INFO_EXT *)OSacquire(sizeof(VIEW_EQUIPMENT_INFO_EXT));
+    if(newViewInfoExt == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    OSmemset(newViewInfoExt, 0, sizeof(VIEW_EQUIPMENT_INFO_EXT));
+    newViewInfoExt->buildStatus = OK;
+    viewInfo = &newViewInfoExt->info;
+
+    FillViewInfoWithEquipmentTypeData(jsonObject, viewInfo);
+
+    //Step - 2: Read the view id, ignore set
+    getJSONObjectForKey(jsonViewData, _T("viewId"), &jsonViewId);
+    if(jsonViewId == NULL)
+    {
+        OSrelease(newViewInfoExt);
+        return ERROR_RESPONSE;
+    }
+
+    jsonTempObj = NULL;
+    getJSONObjectForKey(jsonViewId,_T("id"), &jsonTempObj);
+    if(jsonTempObj != NULL)
+        viewInfo->viewId = (UNSIGNED16)json_integer_value(jsonTempObj);
+
+    //Step - 3: Record internal flag to indicate if this view should be exposed to the outside world
+    getJSONObjectForKey(jsonViewData, _T("internalView"), &jsonTempObj);
+    if(jsonTempObj == NULL)
+    {
+        OSrelease(newViewInfoExt);
+        return ERROR_RESPONSE;
+    }
+    viewInfo->internal = jsonTempObj->type == JSON_TRUE ? 1 : 0;
+
+    //Step - 4: Keep the JSON view, its MenuGroups are built on first use
+    newViewInfoExt->jsonViewData = jsonViewData;
+
+    *viewInfoExt = newViewInfoExt;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   addTopLevelView method
+
+Purpose:  Inserts a recorded view into the top level view list, keeping it sorted
+          by viewId.
+
+Inputs:   topLevelViews - list to insert into
+          numViews - Number of views already in the list
+          viewInfo - the recorded view
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+static void addTopLevelView(VIEW_TOP_LEVEL_VIEW * topLevelViews, UNSIGNED16 numViews, VIEW_EQUIPMENT_INFO * viewInfo)
+{
+    UNSIGNED16 index;
+
+    for(index = numViews; index > 0 && topLevelViews[index - 1].viewId > viewInfo->viewId; index--)
+        topLevelViews[index] = topLevelViews[index - 1];
+
+    topLevelViews[index].viewId = viewInfo->viewId;
+    topLevelViews[index].internal = viewInfo->internal;
+}
+
+/*------------------------------------------------------------------------------
+Module:   RecordViews method
+
+Purpose:  Records every view of the views array and inserts it into viewHash,
+          without building any MenuGroup. Every view takes a reference to its own
+          JSON view, so the caller can release the rest of the view file. The top
+          level view list is built along the way. On error every view recorded so
+          far is removed from viewHash again and the view database is left empty.
+
+Inputs:   viewDb - view database to fill
+          jsonObject - json Object of the view file
+          jsonViewArray - "views" array of the view file
+          itemReference - Item reference of the equipment
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+ERROR_STATUS RecordViews(VIEW_DATABASE * viewDb, json_t * jsonObject, json_t * jsonViewArray, TCHAR * itemReference)
+{
+    VIEW_DATABASE_EXT * viewDbExt = (VIEW_DATABASE_EXT *)viewDb;
+    VIEW_EQUIPMENT_INFO_EXT ** views;
+    VIEW_TOP_LEVEL_VIEW * topLevelViews;
+    json_t * jsonViewData;
+    UNSIGNED16 viewCount, temp, numInserted = 0, keyLength;
+    ERROR_STATUS status = OK;
+
+    //Get the number of views associated.
+    viewCount = (UNSIGNED16)json_array_size(jsonViewArray);
+    if(viewCount == 0)
+        return OK;
+
+    views = (VIEW_EQUIPMENT_INFO_EXT **)OSacquire(sizeof(VIEW_EQUIPMENT_INFO_EXT *) * viewCount);
+    if(views == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    topLevelViews = (VIEW_TOP_LEVEL_VIEW *)OSacquire(sizeof(VIEW_TOP_LEVEL_VIEW) * viewCount);
+    if(topLevelViews == NULL)
+    {
+        OSrelease(views);
+        return NOT_ENOUGH_MEMORY;
+    }
+
+    //Item reference the views are built with later on
+    keyLength = STR_STORE(OSstrlen(itemReference));
+    viewDbExt->itemReference = (TCHAR *)OSacquire(keyLength);
+    if(viewDbExt->itemReference == NULL)
+    {
+        OSrelease(topLevelViews);
+        OSrelease(views);
+        return NOT_ENOUGH_MEMORY;
+    }
+    OSmemcpy(viewDbExt->itemReference, itemReference, keyLength);
+
+    for(temp = 0; temp < viewCount && status == OK; temp++)
+    {
+        jsonViewData = json_array_get(jsonViewArray, temp);
+        if(jsonViewData == NULL)
+        {
+            status = ERROR_RESPONSE;
+            break;
+        }
+
+        status = recordView(jsonObject, jsonViewData, &views[temp]);
+        if(status != OK)
+            break;
+
+        //Insert view Equipment Info to view Hash
+        status = hashtbl_insert(viewDb->viewHash, &views[temp]->info.viewId, views[temp], sizeof(views[temp]->info.viewId));
+        if(status != OK)
+        {
+            OSrelease(views[temp]);
+            break;
+        }
+
+        numInserted++;
+        addTopLevelView(topLevelViews, temp, &views[temp]->info);
+    }
+
+    if(status != OK)
+    {
+        //Take the views back out of viewHash, the view ids inserted are distinct
+        for(temp = 0; temp < numInserted; temp++)
+        {
+            hashtbl_remove(viewDb->viewHash, &views[temp]->info.viewId, sizeof(views[temp]->info.viewId));
+            OSrelease(views[temp]);
+        }
+
+        OSrelease(viewDbExt->itemReference);
+        viewDbExt->itemReference = NULL;
+        OSrelease(topLevelViews);
+        OSrelease(views);
+        return status;
+    }
+
+    //Every view keeps its own JSON view until it is built
+    for(temp = 0; temp < viewCount; temp++)
+        json_incref(views[temp]->jsonViewData);
+
+    viewDbExt->views = views;
+    viewDbExt->topLevelViews = topLevelViews;
+    viewDbExt->numViews = viewCount;
+    viewDbExt->numPendingViews = viewCount;
+
+    //Update View Database with total number of views
+    viewDb->viewCount = viewCount;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   SaveViewOids method
+
+Purpose:  Writes the oids resolved so far to the oid cache file, see SaveViewOidCache.
+          Called whenever a build opened new oids by name.
+
+Inputs:   viewDb - view database
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+void SaveViewOids(VIEW_DATABASE * viewDb)
+{
+    VIEW_DATABASE_EXT * viewDbExt = (VIEW_DATABASE_EXT *)viewDb;
+    MODEL_CLASS_VARS *classVarPtr;
+
+    classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+    if(SaveViewOidCache(viewDb, classVarPtr->view_Version, viewDbExt->itemReference, classVarPtr->template_Version, &viewDbExt->oidCacheStamp) == OK)
+        viewDbExt->newOids = 0;
+}
+
+/*------------------------------------------------------------------------------
+Module:   viewFinished method
+
+Purpose:  Marks a view as built, or as failed when status is not OK. Either way
+          its JSON view is released and the view is never built again, a failed
+          view returns status to every accessor. The oid cache file is updated as
+          soon as oids were opened by name for it, so views built on first use
+          reach the next start too.
+
+Inputs:   viewDbExt - view database
+          viewInfoExt - the view
+          status - outcome of the build
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+static void viewFinished(VIEW_DATABASE_EXT * viewDbExt, VIEW_EQUIPMENT_INFO_EXT * viewInfoExt, ERROR_STATUS status)
+{
+    viewInfoExt->buildStatus = status;
+
+    json_decref(viewInfoExt->jsonViewData);
+    viewInfoExt->jsonViewData = NULL;
+
+    viewDbExt->numPendingViews--;
+
+    //Keep the resolved oids for the next start
+    if(viewDbExt->newOids > 0)
+        SaveViewOids(&viewDbExt->db);
+}
+
+/*------------------------------------------------------------------------------
+Module:   MaterializeView method
+
+Purpose:  Builds the MenuGroups of a recorded view, if not done yet, and resolves
+          its object references. Called by the accessors on first use of a view.
+          A view that failed to build is not tried again, its error is returned.
+
+Inputs:   viewDb - view database
+          viewInfoExt - view to build
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+ERROR_STATUS MaterializeView(VIEW_DATABASE * viewDb, VIEW_EQUIPMENT_INFO_EXT * viewInfoExt)
+{
+    VIEW_DATABASE_EXT * viewDbExt = (VIEW_DATABASE_EXT *)viewDb;
+    VIEW_OID_BATCH oidBatch;
+    ERROR_STATUS status;
+
+    if(viewInfoExt->buildStatus != OK)
+        return viewInfoExt->buildStatus;
+
+    if(viewInfoExt->jsonViewData == NULL)
+        return OK;
+
+    //Out of memory for the batch is not a fault of the view, it is tried again
+    status = InitViewOidBatch(&oidBatch);
+    if(status != OK)
+    {
+        ReleaseViewOidBatch(&oidBatch);
+        return status;
+    }
+
+    status = buildView(viewInfoExt, viewDbExt->itemReference, &oidBatch);
+    if(status == OK)
+        ResolveViewOidBatch(&oidBatch, viewDbExt->itemReference);
+
+    ReleaseViewOidBatch(&oidBatch);
+
+    viewFinished(viewDbExt, viewInfoExt, status);
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   buildViewPartitionTask method
+
+Purpose:  Task building the MenuGroups of the views of one partition. A view that
+          fails keeps its error in buildStatus and the task goes on with the next
+          one. Nothing is built when the partition's oid batch could not be set up.
+
+Inputs:   taskContext - VIEW_BUILD_PARTITION
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+static void buildViewPartitionTask(void * taskContext)
+{
+    VIEW_BUILD_PARTITION * partition = (VIEW_BUILD_PARTITION *)taskContext;
+    VIEW_EQUIPMENT_INFO_EXT * viewInfoExt;
+    UNSIGNED16 temp;
+
+    if(partition->status != OK)
+        return;
+
+    for(temp = partition->firstView; temp < partition->firstView + partition->numViews; temp++)
+    {
+        viewInfoExt = partition->views[temp];
+        if(viewInfoExt->jsonViewData != NULL && viewInfoExt->buildStatus == OK)
+            viewInfoExt->buildStatus = buildView(viewInfoExt, partition->itemReference, &partition->oidBatch);
+    }
+}
+
+/*------------------------------------------------------------------------------
+Module:   BuildViews method
+
+Purpose:  Builds the MenuGroups of every recorded view not built yet, instead of
+          waiting for their first use. The views are cut into numWorkers contiguous
+          partitions built by tasks given to the dispatcher. The tasks share nothing
+          but the read-only JSON views: each defers its object references to its own
+          oid batch and writes only the views of its partition. Once all the tasks
+          have completed, the batches are resolved on the calling thread, so the oid
+          caches are never used concurrently and the result does not depend on the
+          scheduling. Views that failed are marked failed, views of a partition
+          whose batch could not be set up are left to be built on first use.
+
+Inputs:   viewDb - view database, views recorded by RecordViews
+          numWorkers - number of partitions, at most TASK_DISPATCH_MAX_WORKERS
+          dispatch - runs the tasks, NULL for the default dispatcher
+
+Outputs:  ERROR_STATUS returned if on any issue, the first error met
+------------------------------------------------------------------------------*/
+ERROR_STATUS BuildViews(VIEW_DATABASE * viewDb, UNSIGNED16 numWorkers, TASK_DISPATCH dispatch)
+{
+    VIEW_DATABASE_EXT * viewDbExt = (VIEW_DATABASE_EXT *)viewDb;
+    VIEW_BUILD_PARTITION partitions[TASK_DISPATCH_MAX_WORKERS];
+    void * taskContexts[TASK_DISPATCH_MAX_WORKERS];
+    VIEW_EQUIPMENT_INFO_EXT * viewInfoExt;
+    UNSIGNED16 viewCount, temp, first;
+    ERROR_STATUS status = OK;
+
+    if(dispatch == NULL)
+        dispatch = DefaultTaskDispatch;
+
+    viewCount = viewDbExt->numViews;
+    if(viewDbExt->numPendingViews == 0)
+        return OK;
+
+    if(numWorkers > TASK_DISPATCH_MAX_WORKERS)
+        numWorkers = TASK_DISPATCH_MAX_WORKERS;
+    if(numWorkers > viewCount)
+        numWorkers = viewCount;
+    if(numWorkers == 0)
+        numWorkers = 1;
+
+    //Contiguous partitions of near equal size
+    for(temp = 0, first = 0; temp < numWorkers; temp++)
+    {
+        partitions[temp].itemReference = viewDbExt->itemReference;
+        partitions[temp].firstView = first;
+        partitions[temp].numViews = (UNSIGNED16)((UNSIGNED32)viewCount * (temp + 1) / numWorkers) - first;
+        partitions[temp].views = viewDbExt->views;
+        partitions[temp].status = InitViewOidBatch(&partitions[temp].oidBatch);
+        first += partitions[temp].numViews;
+
+        taskContexts[temp] = &partitions[temp];
+    }
+
+    status = dispatch(buildViewPartitionTask, taskContexts, numWorkers);
+
+    //Resolve every distinct object reference once per partition and fill the ObjectOID fields.
+    //A batch only holds the fields of views that were built, so it is resolved whatever happened.
+    for(temp = 0; temp < numWorkers; temp++)
+    {
+        if(status == OK)
+            status = partitions[temp].status;
+
+        if(partitions[temp].status == OK)
+            ResolveViewOidBatch(&partitions[temp].oidBatch, viewDbExt->itemReference);
+
+        ReleaseViewOidBatch(&partitions[temp].oidBatch);
+    }
+
+    for(temp = 0; temp < viewCount; temp++)
+    {
+        viewInfoExt = viewDbExt->views[temp];
+        if(viewInfoExt->jsonViewData == NULL)
+            continue;
+
+        if(viewInfoExt->buildStatus != OK)
+        {
+            if(status == OK)
+                status = viewInfoExt->buildStatus;
+            viewFinished(viewDbExt, viewInfoExt, viewInfoExt->buildStatus);
+        }
+        else if(viewInfoExt->groupBlock != NULL)
+        {
+            viewFinished(viewDbExt, viewInfoExt, OK);
+        }
+    }
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   FindViewGroup method
+
+Purpose:  Returns the MenuGroup of a view for a group handle. Sequential handles are
+          an array index, explicit group ids a binary search of a few entries.
+
+Inputs:   viewInfoExt - view to search
+          groupHandle - handle of the group
+
+Outputs:  Pointer to MenuGroup, NULL if the view has no group with this handle
+------------------------------------------------------------------------------*/
+MenuGroup * FindViewGroup(VIEW_EQUIPMENT_INFO_EXT * viewInfoExt, UNSIGNED16 groupHandle)
+{
+    UNSIGNED16 index, low, high;
+
+    index = (UNSIGNED16)(groupHandle - VIEW_TOP_LEVEL_GROUP_HANDLE);
+    if(groupHandle >= VIEW_TOP_LEVEL_GROUP_HANDLE && index < viewInfoExt->numHandles)
+        return viewInfoExt->groupsByHandle[index];
+
+    low = 0;
+    high = viewInfoExt->numExplicitGroups;
+    while(low < high)
+    {
+        index = (UNSIGNED16)((low + high) / 2);
+        if(viewInfoExt->explicitGroups[index].groupHandle == groupHandle)
+            return viewInfoExt->explicitGroups[index].menuGroup;
+
+        if(viewInfoExt->explicitGroups[index].groupHandle < groupHandle)
+            low = (UNSIGNED16)(index + 1);
+        else
+            high = index;
+    }
+
+    return NULL;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetViewFootprint method
+
+Purpose:  Reports the memory the MenuGroups of a view take in its group block and
+          what they took when every MenuGroup was allocated on its own and entered in
+          the view's group hash. The view is built first if it was not yet.
+
+Inputs:   viewId - view to report
+
+Outputs:  blockBytes - Size of the group block (handle index, explicit groups and
+                       offset table included)
+          legacyBytes - Bytes of the separately allocated MenuGroups and their hash
+                        entries
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetViewFootprint(UNSIGNED16 viewId, UNSIGNED32 * blockBytes, UNSIGNED32 * legacyBytes)
+{
+    VIEW_DATABASE * viewDb;
+    VIEW_EQUIPMENT_INFO_EXT * viewInfoExt;
+    MODEL_CLASS_VARS *classVarPtr;
+    ERROR_STATUS status;
+
+    // get ptr to the model's class vars
+    classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+    viewDb = classVarPtr->view_database;
+    if(viewDb == NULL)
+        return VIEW_DATABASE_NOT_FOUND;
+
+    if(hashtbl_get(viewDb->viewHash, &viewId, sizeof(viewId), (void **)&viewInfoExt))
+        return JSONVIEW_NOT_FOUND;
+
+    status = MaterializeView(viewDb, viewInfoExt);
+    if(status != OK)
+        return status;
+
+    *blockBytes = viewInfoExt->groupBlockSize;
+    *legacyBytes = viewInfoExt->legacyBytes;
+
+    return OK;
+}
@@ -0,0 +1,250 @@
+/***************************************************************************
+
+
+Description: This file holds the private structures and function prototypes
+             of the view library built on top of view_api_private.h.
+
+File Name: view_ext_private.h
+
+***************************************************************************/
+#ifndef VIEWEXT_PRIVATE_H
+#define VIEWEXT_PRIVATE_H
+#include <view_api.h>
+#include "view_api_private.h"
+#include <task_dispatch.h>
+
+//Group handle of the top level group of a view, the following groups without an
+//explicit "id" are numbered from there in the order they appear in the view
+#define VIEW_TOP_LEVEL_GROUP_HANDLE     1000
+
+//All MenuGroups of a view live in one block, laid out in the order the view is
+//traversed (group, then its child groups depth first). Each MenuGroup takes room for
+//exactly its elements, rounded up to VIEW_GROUP_BLOCK_ALIGN.
+#define VIEW_GROUP_BLOCK_ALIGN          8
+#define VIEW_MENU_GROUP_SIZE(count)     ((sizeof(MenuGroup) + ((count) > 1 ? ((UNSIGNED32)(count) - 1) * sizeof(MenuElement) : 0) + \
+                                          VIEW_GROUP_BLOCK_ALIGN - 1) & ~(UNSIGNED32)(VIEW_GROUP_BLOCK_ALIGN - 1))
+//What a MenuGroup took when every group was allocated on its own (sized by MenuGroup per
+//element) and entered in the view's group hash (node and key)
+#define VIEW_LEGACY_MENU_GROUP_SIZE(count) (sizeof(MenuGroup) * ((count) > 1 ? (UNSIGNED32)(count) : 1) + \
+                                            sizeof(struct hashEntry_s) + sizeof(UNSIGNED16))
+
+//Object references met while building the views are resolved to oids in one batch
+//once all the views are laid out, every distinct reference once
+#define VIEW_OID_BATCH_GROW_SIZE        64
+
+typedef struct
+{
+    const SIGNED8 * objReference;           //ASCII object reference as in the JSON view
+    OID_TYPE oid;
+} VIEW_OID_REFERENCE;
+
+typedef struct
+{
+    VIEW_OID_REFERENCE * reference;
+    OID_TYPE * oidSlot;                     //ObjectOID field to fill with the resolved oid
+} VIEW_OID_SLOT;
+
+typedef struct
+{
+    APSHASHTBL * referenceHash;             //objReference -> VIEW_OID_REFERENCE
+    VIEW_OID_REFERENCE ** references;       //Distinct references in the order they were met
+    UNSIGNED32 numReferences;
+    UNSIGNED32 maxReferences;
+    VIEW_OID_SLOT * slots;
+    UNSIGNED32 numSlots;
+    UNSIGNED32 maxSlots;
+} VIEW_OID_BATCH;
+
+//Resolves the oid of every reference of a batch. The default resolver opens a
+//connection by name for each reference not in the view database's oidHash.
+typedef void (*VIEW_OID_RESOLVER)(TCHAR * itemReference, VIEW_OID_REFERENCE ** references, UNSIGNED32 numReferences);
+
+//Oid cache in front of oidHash, organized as itemReference -> (objectReference -> oid)
+//so a hit neither builds the full qualified reference name nor hashes the item reference
+#define VIEW_ITEM_OID_GROW_SIZE         4
+
+typedef struct
+{
+    TCHAR * itemReference;                  //Copy of the item reference
+    APSHASHTBL * objectOidHash;             //ASCII objectReference -> OID_TYPE
+} VIEW_ITEM_OID_CACHE;
+
+//What the oid cache file holds, to tell whether the resolved oids still match it
+typedef struct
+{
+    UNSIGNED32 entryCount;
+    UNSIGNED32 digest;                      //Sum of the entry checksums, whatever the entry order
+} VIEW_OID_CACHE_STAMP;
+
+//Entry of the top level view list handed to the UI, kept sorted by viewId
+typedef struct
+{
+    UNSIGNED16 viewId;
+    UNSIGNED8 internal;
+} VIEW_TOP_LEVEL_VIEW;
+
+//The view database is allocated as VIEW_DATABASE_EXT, VIEW_DATABASE must stay first
+typedef struct
+{
+    VIEW_DATABASE db;
+    APSHASHTBL * itemOidHash;               //itemReference -> VIEW_ITEM_OID_CACHE
+    VIEW_ITEM_OID_CACHE * lastItemOidCache; //Item cache of the previous lookup
+    UNSIGNED32 oidCacheHits;
+    UNSIGNED32 oidCacheMisses;
+    TCHAR * itemReference;                  //Copy of the item reference the views are built for
+    struct VIEW_EQUIPMENT_INFO_EXT_s ** views; //Views in the order of the views array
+    UNSIGNED16 numViews;
+    UNSIGNED16 numPendingViews;             //Views neither built nor failed yet
+    VIEW_OID_CACHE_STAMP oidCacheStamp;     //What the oid cache file holds
+    UNSIGNED32 newOids;                     //Oids opened by name since the file was last saved
+    VIEW_TOP_LEVEL_VIEW * topLevelViews;    //Every recorded view, sorted by viewId
+} VIEW_DATABASE_EXT;
+
+//Resolved oids are kept in a cache file next to the view file (same name +
+//VIEW_OID_CACHE_SUFFIX) and loaded into oidHash on the next start, as long as the view
+//version, the item reference and the template version recorded in it match the ones
+//being initialized. None of these identify the object database, so before the oids are
+//used VIEW_OID_CACHE_PROBES of them, spread over the file, are opened by name again; a
+//single one resolving differently discards the file. The file is written again whenever
+//the resolved oids differ from what it holds.
+#define VIEW_OID_CACHE_MAGIC            0x44494F56   //"VOID"
+#define VIEW_OID_CACHE_VERSION          2
+#define VIEW_OID_CACHE_SUFFIX           _T(".oid")
+#define VIEW_OID_CACHE_PROBES           4
+
+typedef struct
+{
+    UNSIGNED32 magic;
+    UNSIGNED16 cacheVersion;
+    UNSIGNED16 oidSize;                     //sizeof(OID_TYPE) of the build that wrote it
+    UNSIGNED32 entryCount;
+    UNSIGNED32 payloadSize;                 //Bytes following this header
+    UNSIGNED32 payloadChecksum;
+} VIEW_OID_CACHE_HEADER;
+
+//InitializeView only records the views (viewId, internal flag, JSON view), the
+//MenuGroups of a view are built the first time one of its groups is asked for.
+//Each view holds a reference to its own JSON view only, the rest of the view file is
+//released by InitializeView. Errors in the JSON of a view are reported by the first
+//accessor of the view, which then keeps returning them.
+//
+//Parallel view build: the views are split in array order into up to
+//TASK_DISPATCH_MAX_WORKERS partitions, each built by a task handed to the dispatcher
+//(task_dispatch.h) with its own oid batch. Tasks only read the JSON view and write their
+//own views, the oids are resolved on the calling thread afterwards.
+
+//Group with an explicit "id" outside the sequential handle range
+typedef struct
+{
+    UNSIGNED16 groupHandle;
+    MenuGroup * menuGroup;
+} VIEW_EXPLICIT_GROUP;
+
+//Every view entry in viewHash is allocated as VIEW_EQUIPMENT_INFO_EXT, the
+//VIEW_EQUIPMENT_INFO must stay the first member so the entry can be handed out as is.
+typedef struct VIEW_EQUIPMENT_INFO_EXT_s
+{
+    VIEW_EQUIPMENT_INFO info;
+    json_t * jsonViewData;                  //Own reference to the JSON view, NULL once built or failed
+    ERROR_STATUS buildStatus;               //Error of a failed build, the view is not built again
+    UNSIGNED8 * groupBlock;                 //MenuGroups, handle index, explicit groups, offset table
+    UNSIGNED32 groupBlockSize;
+    UNSIGNED32 * groupOffsets;              //Offset of every MenuGroup in groupBlock, in layout order
+    UNSIGNED16 numGroups;
+    UNSIGNED32 legacyBytes;                 //Bytes the MenuGroups took as separate allocations
+    MenuGroup ** groupsByHandle;            //Indexed by groupHandle - VIEW_TOP_LEVEL_GROUP_HANDLE
+    UNSIGNED16 numHandles;
+    VIEW_EXPLICIT_GROUP * explicitGroups;   //Sorted by groupHandle
+    UNSIGNED16 numExplicitGroups;
+    struct VIEW_PRESENCE_s * presence;      //Presence evaluation, NULL until first asked for
+} VIEW_EQUIPMENT_INFO_EXT;
+
+//Presence evaluation: the presence indicators of a view are collected once, every
+//distinct (ObjectOID, AttrRef, data type) point is read once per evaluation and the
+//outcome kept in a bitmap, one bit per element of every group in layout order. The
+//bitmap is evaluated on every call; only a view whose points report their changes
+//(EnableViewPresenceCache) keeps it until InvalidateViewPresence reports a change of one
+//of them. Elements without a presence indicator, or whose point cannot be read, are
+//present.
+//The operator decides the data type: EQUAL and NOTEQUAL may only be used on enum, state
+//and unsigned points, read as unsigned and compared with the constant as is. GREATER and
+//LESSER are for numeric points, read as a real and compared with the constant as signed.
+#define VIEW_PRESENCE_ENUM_DATA_TYPE    UNSIGNED_DATA_TYPE
+#ifdef USE_DOUBLE
+#define VIEW_PRESENCE_REAL_DATA_TYPE    DOUBLE_DATA_TYPE
+#define VIEW_PRESENCE_REAL_VALUE(parm)  ((parm).parmValue.tDouble)
+typedef FLOAT64 VIEW_PRESENCE_REAL;
+#else
+#define VIEW_PRESENCE_REAL_DATA_TYPE    FLOAT_DATA_TYPE
+#define VIEW_PRESENCE_REAL_VALUE(parm)  ((parm).parmValue.tFloat)
+typedef FLOAT32 VIEW_PRESENCE_REAL;
+#endif
+#define VIEW_PRESENCE_WORD_BITS         32
+#define VIEW_PRESENCE_HASH_MAX_SIZE     256
+
+typedef struct
+{
+    OID_TYPE objectOid;
+    UNSIGNED16 attrRef;
+    UNSIGNED16 dataType;                    //VIEW_PRESENCE_ENUM_DATA_TYPE or VIEW_PRESENCE_REAL_DATA_TYPE
+} VIEW_PRESENCE_READ_KEY;
+
+typedef struct
+{
+    VIEW_PRESENCE_READ_KEY key;             //Point read and the data type it is read in
+    ERROR_STATUS readStatus;
+    UNSIGNED32 value;                       //Value read as enum/unsigned
+    VIEW_PRESENCE_REAL realValue;           //Value read as real
+} VIEW_PRESENCE_READ;
+
+typedef struct
+{
+    UNSIGNED32 bit;                         //Bit of the element in the bitmap
+    UNSIGNED32 readIndex;                   //Read of the element's point
+    UNSIGNED32 piConstant;
+    UNSIGNED8 piOperator;
+} VIEW_PRESENCE_POINT;
+
+typedef struct VIEW_PRESENCE_s
+{
+    VIEW_PRESENCE_READ * reads;             //Distinct points of the view
+    UNSIGNED32 numReads;
+    VIEW_PRESENCE_POINT * points;           //Elements with a presence indicator
+    UNSIGNED32 numPoints;
+    UNSIGNED32 * groupFirstBit;             //First bit of every MenuGroup, in layout order
+    UNSIGNED32 * bitmap;
+    UNSIGNED32 numBits;
+    UNSIGNED8 valid;                        //FALSE once one of the points changed
+    UNSIGNED8 notified;                     //TRUE once changes of the points get reported
+} VIEW_PRESENCE;
+
+ERROR_STATUS FillMenuGroupPointer(MenuGroup * menuGroup, json_t * jsonGroupObj, UNSIGNED16 menuElementIndex, UNSIGNED16 grpHandle, TCHAR * itemReference, VIEW_OID_BATCH * oidBatch);
+ERROR_STATUS FillPresenceIndicatorDeferred(json_t * jsonGrpPresenceIndicator, UNSIGNED16 menuElementIndex, TCHAR * itemReference, MenuGroup * menuGroup, VIEW_OID_BATCH * oidBatch);
+ERROR_STATUS FillMenuDataPointsDeferred(json_t * jsonElementArray, MenuGroup * menuGroup, UNSIGNED16 numElements, TCHAR * itemReference, VIEW_OID_BATCH * oidBatch);
+ERROR_STATUS BuildViewGroups(json_t * jsonViewData, TCHAR * itemReference, VIEW_OID_BATCH * oidBatch, VIEW_EQUIPMENT_INFO_EXT * viewInfoExt);
+ERROR_STATUS RecordViews(VIEW_DATABASE * viewDb, json_t * jsonObject, json_t * jsonViewArray, TCHAR * itemReference);
+ERROR_STATUS MaterializeView(VIEW_DATABASE * viewDb, VIEW_EQUIPMENT_INFO_EXT * viewInfoExt);
+void SaveViewOids(VIEW_DATABASE * viewDb);
+ERROR_STATUS BuildViews(VIEW_DATABASE * viewDb, UNSIGNED16 numWorkers, TASK_DISPATCH dispatch);
+ERROR_STATUS InitializeViewParallel(TCHAR * itemReference, json_t * jsonObject, UNSIGNED16 numWorkers, TASK_DISPATCH dispatch);
+MenuGroup * FindViewGroup(VIEW_EQUIPMENT_INFO_EXT * viewInfoExt, UNSIGNED16 groupHandle);
+ERROR_STATUS GetViewFootprint(UNSIGNED16 viewId, UNSIGNED32 * blockBytes, UNSIGNED32 * legacyBytes);
+ERROR_STATUS GetTopLevelViewArray(const VIEW_TOP_LEVEL_VIEW ** topLevelViews, UNSIGNED16 * numViews);
+ERROR_STATUS GetViewPresence(UNSIGNED16 viewId, const UNSIGNED32 ** bitmap, UNSIGNED32 * numBits);
+ERROR_STATUS IsGroupElementPresent(UNSIGNED16 viewId, UNSIGNED16 groupHandle, UNSIGNED16 elementIndex, UNSIGNED8 * present);
+ERROR_STATUS EnableViewPresenceCache(UNSIGNED16 viewId);
+ERROR_STATUS InvalidateViewPresence(OID_TYPE objectOid, UNSIGNED16 attrRef);
+
+ERROR_STATUS InitViewOidBatch(VIEW_OID_BATCH * oidBatch);
+ERROR_STATUS DeferViewOid(VIEW_OID_BATCH * oidBatch, const SIGNED8 * objReference, OID_TYPE * oidSlot);
+void ResolveViewOidBatch(VIEW_OID_BATCH * oidBatch, TCHAR * itemReference);
+void ReleaseViewOidBatch(VIEW_OID_BATCH * oidBatch);
+void SetViewOidResolver(VIEW_OID_RESOLVER resolver);
+OID_TYPE * FindItemOid(VIEW_DATABASE * viewDb, TCHAR * itemReference, const SIGNED8 * objReference);
+ERROR_STATUS AddItemOid(VIEW_DATABASE * viewDb, TCHAR * itemReference, const SIGNED8 * objReference, OID_TYPE oidVal);
+ERROR_STATUS GetViewOidCacheStats(UNSIGNED32 * hits, UNSIGNED32 * misses);
+ERROR_STATUS LoadViewOidCache(VIEW_DATABASE * viewDb, TCHAR * viewVersion, TCHAR * itemReference, TCHAR * templateVersion, VIEW_OID_CACHE_STAMP * stamp);
+ERROR_STATUS SaveViewOidCache(VIEW_DATABASE * viewDb, TCHAR * viewVersion, TCHAR * itemReference, TCHAR * templateVersion, VIEW_OID_CACHE_STAMP * stamp);
+OID_TYPE OpenViewOidByName(TCHAR * fqrRef);
+
+#endif
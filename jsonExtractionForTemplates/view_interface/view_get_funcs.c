@@ -13,6 +13,7 @@ Outputs:  Returns the data asked by the local UI
 ------------------------------------------------------------------------------*/
 #include <view_api.h>
 #include "view_api_private.h"
+#include "view_ext_private.h"
 
 /*-------------------------------------------------------------------------------
 Module:   GetGroupByHandle method
@@ -28,8 +29,9 @@ Outputs:  Menu Group structure of type MenuGroup
 ERROR_STATUS GetGroupByHandle(UNSIGNED16 viewId, UNSIGNED16 groupHandle,  MenuGroup ** menuGroup)
 {
     VIEW_DATABASE * viewDb;
-    VIEW_EQUIPMENT_INFO * viewInfo;
+    VIEW_EQUIPMENT_INFO_EXT * viewInfo;
     MODEL_CLASS_VARS *classVarPtr;
+    ERROR_STATUS status;
 
     // get ptr to the model's class vars
     classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
@@ -44,12 +46,16 @@ ERROR_STATUS GetGroupByHandle(UNSIGNED16 viewId, UNSIGNED16 groupHandle,  MenuGr
     if(hashtbl_get(viewDb->viewHash, &viewId, sizeof(viewId), (void **)&viewInfo))
         return JSONVIEW_NOT_FOUND;
 
+    //Build the view's MenuGroups on first use
+    status = MaterializeView(viewDb, viewInfo);
+    if(status != OK)
+        return status;
+
     //Pick menuGroup based on the passed in group handle
-    if(viewInfo->viewGrpHash == NULL)
+    if(viewInfo->groupsByHandle == NULL)
         return JSONVIEW_GROUPHASH_NOT_FOUND;
 
-    if(hashtbl_get(viewInfo->viewGrpHash, &groupHandle, sizeof(groupHandle), (void **)menuGroup))
-        return JSONVIEW_MENUGROUP_NOT_FOUND;
+    *menuGroup = FindViewGroup(viewInfo, groupHandle);
 
     if(*menuGroup == NULL)
         return JSONVIEW_MENUGROUP_NOT_FOUND;
@@ -71,11 +77,9 @@ Outputs:  Pointer to MenuGroup
 ERROR_STATUS GetViewGroup(UNSIGNED16 viewId, MenuGroup ** menuGroup)
 {	
     VIEW_DATABASE * viewDb;
-    VIEW_EQUIPMENT_INFO * viewInfo;
+    VIEW_EQUIPMENT_INFO_EXT * viewInfo;
     MODEL_CLASS_VARS *classVarPtr;
-
-    //The top level group will always have a groupHandle of 1000
-    UNSIGNED16 groupHandle = 1000;
+    ERROR_STATUS status;
 
     // get ptr to the model's class vars
     classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
@@ -90,12 +94,16 @@ ERROR_STATUS GetViewGroup(UNSIGNED16 viewId, MenuGroup ** menuGroup)
     if(hashtbl_get(viewDb->viewHash, &viewId, sizeof(viewId), (void **)&viewInfo))
         return JSONVIEW_NOT_FOUND;
 
-    //Pick menuGroup based on the passed in group handle
-    if(viewInfo->viewGrpHash == NULL)
+    //Build the view's MenuGroups on first use
+    status = MaterializeView(viewDb, viewInfo);
+    if(status != OK)
+        return status;
+
+    //The top level group will always have a groupHandle of 1000
+    if(viewInfo->groupsByHandle == NULL)
         return JSONVIEW_GROUPHASH_NOT_FOUND;
 
-    if(hashtbl_get(viewInfo->viewGrpHash, &groupHandle, sizeof(groupHandle), (void **)menuGroup))
-        return JSONVIEW_MENUGROUP_NOT_FOUND;
+    *menuGroup = viewInfo->groupsByHandle[0];
 
     if(*menuGroup == NULL)
         return JSONVIEW_MENUGROUP_NOT_FOUND;
@@ -129,41 +137,66 @@ ERROR_STATUS GetViewGroup(UNSIGNED16 viewId, MenuGroup ** menuGroup)
 *******************************************************************************/
 ERROR_STATUS GetTopLevelViews(PARM_DATA* pOutputList)
 {
-  VIEW_DATABASE * viewDb;
-  VIEW_EQUIPMENT_INFO * viewInfo;
-  struct hashEntry_s *node;
+  const VIEW_TOP_LEVEL_VIEW * topLevelViews;
   PARM_DATA* pParm;
   PARM_DATA* pView;
   ERROR_STATUS status;
-  MODEL_CLASS_VARS *classVarPtr;
+  UNSIGNED16 numViews;
+  UNSIGNED16 temp;
 
-  // get ptr to the model's class vars
-  classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+  //The list is filled from the views recorded by InitializeView, sorted by viewId
+  status = GetTopLevelViewArray(&topLevelViews, &numViews);
 
-  //Get the view DB
-  viewDb = classVarPtr->view_database;
-
-  if (viewDb == NULL)
+  if (status == OK)
   {
-    status = VIEW_DATABASE_NOT_FOUND;
-  }
-  else
-  {
-    for (node = viewDb->viewHash->nodes[0]; node != NULL; node = node->next)
+    for (temp = 0; temp < numViews; temp++)
     {
-      viewInfo = (VIEW_EQUIPMENT_INFO*)node->data;
       pParm = apsNextListElement(pOutputList);
       apsNewList(pParm, 2);
       pView = apsNextListElement(pParm);
       pView->dataType = USHORT_DATA_TYPE;
-      pView->parmValue.tUnint = viewInfo->viewId;
+      pView->parmValue.tUnint = topLevelViews[temp].viewId;
       pView = apsNextListElement(pParm);
       pView->dataType = BYTE_DATA_TYPE;
-      pView->parmValue.tByte = viewInfo->internal;
+      pView->parmValue.tByte = topLevelViews[temp].internal;
     }
-
-    status = OK;
   }
 
   return status;
 }
+
+/*******************************************************************************
+  Method:  GetTopLevelViewArray
+
+  Purpose: Returns the top level views as the array built by InitializeView,
+           without wrapping them in a JCI list. The array is sorted by viewId
+           and stays owned by the view database.
+
+  Inputs:  topLevelViews -- [OUT] The (viewId, internal) array
+           numViews -- [OUT] Number of entries in the array
+
+  Return:  OK if the view database is available,
+           VIEW_DATABASE_NOT_FOUND otherwise.
+           Note that OK is returned with no entries if no view was recorded.
+*******************************************************************************/
+ERROR_STATUS GetTopLevelViewArray(const VIEW_TOP_LEVEL_VIEW ** topLevelViews, UNSIGNED16 * numViews)
+{
+  VIEW_DATABASE_EXT * viewDbExt;
+  MODEL_CLASS_VARS *classVarPtr;
+
+  // get ptr to the model's class vars
+  classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+  //Get the view DB
+  viewDbExt = (VIEW_DATABASE_EXT *)classVarPtr->view_database;
+
+  if (viewDbExt == NULL)
+  {
+    return VIEW_DATABASE_NOT_FOUND;
+  }
+
+  *topLevelViews = viewDbExt->topLevelViews;
+  *numViews = viewDbExt->numViews;
+
+  return OK;
+}
@@ -14,6 +14,7 @@ Outputs:  NA
 ------------------------------------------------------------------------------*/
 #include <view_api.h>
 #include "view_api_private.h"
+#include "view_ext_private.h"
 
 CLASS_INDEX equipmentModelClassIndex = 0;
 
@@ -43,10 +44,12 @@ ERROR_STATUS InitView()
     classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
 
     //Allocate memory for Template
-    viewDb = (VIEW_DATABASE *)OSacquire(sizeof(VIEW_DATABASE));
+    viewDb = (VIEW_DATABASE *)OSacquire(sizeof(VIEW_DATABASE_EXT));
     if(viewDb == NULL)
         return NOT_ENOUGH_MEMORY;
 
+    OSmemset(viewDb, 0, sizeof(VIEW_DATABASE_EXT));
+
     //Hash list to store the viewId and its corresponding reference to menu Grup Pointer
     if((viewHash=hashtbl_create(VIEW_DB_ENTRY_GROW_SIZE, HASH_TYPE_INT)) == NULL) 
         return HASH_CREATE_ERROR;
@@ -67,33 +70,29 @@ ERROR_STATUS InitView()
 }
 
 /*------------------------------------------------------------------------------
-Module:   InitializeView method
+Module:   initializeViews method
 
-Purpose:  This function is called when view needs to be initialized, 
-          Called by the equipment object when device is idle.
-          Parses the JSON file and pushes data into hash
+Purpose:  Parses the JSON view and records its views in the view database. With
+          numWorkers > 0 the views are built right away, split across numWorkers
+          tasks given to dispatch (see BuildViews). Else each view is built on
+          first use.
 
 Inputs:   itemReference: Pointer to top level object item Reference
           jsonObject: Pointer to json Object that holds the JSON view
+          numWorkers, dispatch: see BuildViews, 0 to build the views on first use
 
 Outputs:  There could be a possibility that this is called multiple times. First check if viewDatabase 
           already has views in it. If exists just return.
           Else fill MenuGroup structures from jsonObject, Returns OK
 ------------------------------------------------------------------------------*/
-ERROR_STATUS InitializeView(TCHAR*  itemReference, json_t * jsonObject)
+static ERROR_STATUS initializeViews(TCHAR*  itemReference, json_t * jsonObject, UNSIGNED16 numWorkers, TASK_DISPATCH dispatch)
 {	
-    APSHASHTBL *viewGroupHash = NULL; //Reference to store view Groups - Group Handle & MenuGroup Pointer
     VIEW_DATABASE * viewDb;
+    VIEW_DATABASE_EXT * viewDbExt;
     ERROR_STATUS status = OK;
-    json_t *jsonViewArray, *jsonViewGroupArray, *jsonViewId, *jsonTempObj;
-    UNSIGNED16 viewCount, temp, groupTemp, viewId = 0, groupSize, elementsCount  = 0;
-    UNSIGNED16 * groupHandle;
-    MenuGroup *menuGroup, *newmenuGroup = NULL; //Reference to menu Group structure
-    UNSIGNED8 elementType;
+    json_t *jsonViewArray;
     MODEL_CLASS_VARS* classVarPtr = NULL;
-
-    json_t *jsonViewData, *jsonGroupData, *jsonVersionObject = NULL;
-    VIEW_EQUIPMENT_INFO * viewInfo = NULL;
+    json_t *jsonVersionObject = NULL;
     const SIGNED8 * viewVersion;
 
     UNSIGNED16 * unicodeviewVersion = NULL;
@@ -107,10 +106,7 @@ ERROR_STATUS InitializeView(TCHAR*  itemReference, json_t * jsonObject)
     if(viewDb->viewCount > 0) //View Count greater than 0, data is already parsed just return.
         return OK;
 
-    //Allocate groupHandle
-    groupHandle = (UNSIGNED16 *)OSacquire(sizeof(UNSIGNED16));
-    if(groupHandle == NULL)
-        return NOT_ENOUGH_MEMORY;	
+    viewDbExt = (VIEW_DATABASE_EXT *)viewDb;
 
     getJSONObjectForKey(jsonObject, _T("Version"), &jsonVersionObject);
 
@@ -133,130 +129,66 @@ ERROR_STATUS InitializeView(TCHAR*  itemReference, json_t * jsonObject)
     getJSONObjectForKey(jsonObject, _T("views"), &jsonViewArray);
     if(jsonViewArray != NULL)
     {	
-        //Get the number of views associated.
-        viewCount = (UNSIGNED16)json_array_size(jsonViewArray);	
-
-        //Loop through the view array, get index and pass to Read
-        for(temp = 0; temp < viewCount; temp++)
-        {	
-            //Step - 1: Initialize GroupHash
-            //Hash list to store the groupHandle and its corresponding reference to menu Group Pointer
-            if((viewGroupHash=hashtbl_create(VIEW_DB_GROUP_ENTRY_GROW_SIZE, HASH_TYPE_INT)) == NULL) 
-                return HASH_CREATE_ERROR;
-
-            *groupHandle = 1000; //Initial value of group Handle - Refer design spec for this number.
-
-            //Allocate ViewEquipmentInfo structure
-            viewInfo = (VIEW_EQUIPMENT_INFO *)OSallocate(sizeof(VIEW_EQUIPMENT_INFO));
-            if(viewInfo == NULL)
-                return NOT_ENOUGH_MEMORY;
-
-            FillViewInfoWithEquipmentTypeData(jsonObject, viewInfo);	
-
-            //Step - 2: Read JSON Object for the view
-            jsonViewData = json_array_get(jsonViewArray, temp);
-            if(jsonViewData == NULL)
-                return ERROR_RESPONSE;
-
-            getJSONObjectForKey(jsonViewData, _T("viewId"), &jsonViewId);
-            if(jsonViewId == NULL)
-                return ERROR_RESPONSE;
-
-              //Get the enum view id, ignore set
-            jsonTempObj = NULL;
-            getJSONObjectForKey(jsonViewId,_T("id"), &jsonTempObj);
-            if(jsonTempObj != NULL)
-                viewId = (UNSIGNED16)json_integer_value(jsonTempObj);
-
-            //Step -3 : Retreive element type, element count and element Array
-            status = getGroupElementTypeCountAndElements(jsonViewData, &elementType, &elementsCount, &jsonViewGroupArray);
-            if(status != OK)
-                return status;
-
-            //Step - 4: Allocate MenuGroup pointer
-            groupSize = sizeof(MenuGroup); //Has room for 1 MenuElement already
-            if (elementsCount > 1)
-                groupSize += (UNSIGNED16)((elementsCount - 1) * sizeof(MenuGroup));
-            menuGroup = (MenuGroup *)OSallocate(groupSize);
-
-            if(menuGroup == NULL)
-                return NOT_ENOUGH_MEMORY;
-
-
-            //Update menuGroup structure except Group Elements - Top Level will always "act" as a group
-            //Group Handle will always be 1000
-            menuGroup->ElementType = elementType;
-            menuGroup->GroupHandle = *groupHandle;
-            menuGroup->Count = elementsCount;
-
-            //Step - 5: Add to Hash - Top level menuGroup for this view
-            status = hashtbl_insert(viewGroupHash, &menuGroup->GroupHandle, menuGroup, sizeof(menuGroup->GroupHandle));
-            if (status != OK)
-                return status;
-
-            //Step - 6: Increment groupHandle value
-            (*groupHandle)++;
-
-
-            if(elementType == VALUE_ELEMENT_TYPE)
-            {
-                //Step - 7: Value Elements.. Fill with Menu Data points
-                FillMenuDataPoints(jsonViewGroupArray, menuGroup, elementsCount, itemReference);
-            }
-            else
-            {
-
-                //Step - 7: Loop through Group Element array (This can contain just value elements also...)
-                for(groupTemp = 0; groupTemp < elementsCount; groupTemp++)
-                {
-                    jsonGroupData = json_array_get(jsonViewGroupArray, groupTemp);
-
-                    if(jsonGroupData == NULL)
-                        return ERROR_RESPONSE;
-
-                    //Step - 8: Add this Group Information to menuGroup (Its label set, label enum, groupId)	
-                    //groupTemp is passed to insert menuElement at that index. i.e MenuGroup's Element(groupTemp) will be filled
-                    //groupHandle is passed to update MenuGroupPointer with the groupHandle if groupId do not exist
-                    AddMenuGroupPointerToMenuGroup(menuGroup, jsonGroupData, groupTemp, groupHandle, itemReference, &newmenuGroup);					
-
-                    //Step - 9: Add this to Menu Group (Recursive Function)
-                    AddNewMenuGroup(jsonGroupData, viewGroupHash, newmenuGroup, groupHandle, itemReference);
-                }
-
-            }	
-
-            //Step - 10: Fill ViewEquipmentInfo Structure
-            viewInfo->toplevelGroup = menuGroup;
-            viewInfo->viewGrpHash = viewGroupHash;
-            viewInfo->viewId = viewId;
-
-            //Step - 11: Record internal flag to indicate if this view should be exposed to the outside world
-            getJSONObjectForKey(jsonViewData, _T("internalView"), &jsonTempObj);
-            if(jsonTempObj == NULL)
-                return ERROR_RESPONSE;
-            viewInfo->internal = jsonTempObj->type == JSON_TRUE ? 1 : 0;
+        //Oids resolved on a previous start for this view version, item reference and data model,
+        //as long as the objects probed still resolve to them
+        LoadViewOidCache(viewDb, classVarPtr->view_Version, itemReference, classVarPtr->template_Version, &viewDbExt->oidCacheStamp);
 
-            //Insert view Equipment Info to view Hash
-            status = hashtbl_insert(viewDb->viewHash, &viewId, viewInfo, sizeof(viewId));
-
-            if (status != OK)
-                return status;
+        //Record the views and add them to the view Hash, every view keeps its own JSON view
+        status = RecordViews(viewDb, jsonObject, jsonViewArray, itemReference);
 
-        }//End of View For
+        //Build them now if asked to
+        if(status == OK && numWorkers > 0)
+            status = BuildViews(viewDb, numWorkers, dispatch);
 
-        //Update View Database with total number of views
-        viewDb->viewCount = viewCount;			
+        //The oid cache file is saved by the builds that open new oids
     }
 
 
-    //Release group handle
-    OSrelease(groupHandle);
-
-    //Deallocate json objects 
+    //Deallocate json objects, only the JSON views of the views not built yet remain
     json_decref(jsonObject);
 
     
-    return OK;
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   InitializeView method
+
+Purpose:  This function is called when view needs to be initialized, 
+          Called by the equipment object when device is idle.
+          Parses the JSON file and pushes data into hash. Only the views are
+          recorded, the MenuGroups of a view are built on its first
+          GetViewGroup/GetGroupByHandle.
+
+Inputs:   itemReference: Pointer to top level object item Reference
+          jsonObject: Pointer to json Object that holds the JSON view
+
+Outputs:  There could be a possibility that this is called multiple times. First check if viewDatabase 
+          already has views in it. If exists just return.
+          Else fill MenuGroup structures from jsonObject, Returns OK
+------------------------------------------------------------------------------*/
+ERROR_STATUS InitializeView(TCHAR*  itemReference, json_t * jsonObject)
+{
+    return initializeViews(itemReference, jsonObject, 0, NULL);
+}
+
+/*------------------------------------------------------------------------------
+Module:   InitializeViewParallel method
+
+Purpose:  Same as InitializeView but builds every view right away, by up to
+          numWorkers tasks run by dispatch. The object references are still resolved
+          on the calling thread.
+
+Inputs:   itemReference: Pointer to top level object item Reference
+          jsonObject: Pointer to json Object that holds the JSON view
+          numWorkers: number of tasks, at most TASK_DISPATCH_MAX_WORKERS
+          dispatch: runs the tasks, NULL for the default dispatcher
+
+Outputs:  Same as InitializeView
+------------------------------------------------------------------------------*/
+ERROR_STATUS InitializeViewParallel(TCHAR*  itemReference, json_t * jsonObject, UNSIGNED16 numWorkers, TASK_DISPATCH dispatch)
+{
+    return initializeViews(itemReference, jsonObject, numWorkers, dispatch);
 }
 
 CLASS_INDEX getEquipmentModelClassIndexHelper(void)
@@ -0,0 +1,824 @@
+/*------------------------------------------------------------------------------
+
+Module:   View Interface
+
+Purpose:  Resolves the object references of the views to oids. While the views are
+          built every object reference is only recorded together with the ObjectOID
+          field it belongs to. Once all the views are laid out the distinct references
+          are resolved in one batch and the recorded fields are filled.
+          Resolved oids are persisted in a cache file so the next start does not
+          resolve them again.
+
+Filename: view_oid.c
+
+Inputs:   ASCII object references from the JSON view and the item reference
+
+Outputs:  ObjectOID fields of the MenuGroups
+------------------------------------------------------------------------------*/
+#include <view_api.h>
+#include "view_api_private.h"
+#include "view_ext_private.h"
+#include <oreResources.h>
+#include <fileio.h>
+
+static void resolveViewOidsByName(TCHAR * itemReference, VIEW_OID_REFERENCE ** references, UNSIGNED32 numReferences);
+
+//Resolver used by ResolveViewOidBatch - can be replaced by a bulk resolver or a local stand-in
+static VIEW_OID_RESOLVER viewOidResolver = resolveViewOidsByName;
+
+/*------------------------------------------------------------------------------
+Module:   resolveViewOidsByName method
+
+Purpose:  Default resolver. Resolves every reference through the view database's
+          oidHash and opens a connection by name for the ones not in it.
+
+Inputs:   itemReference - Item reference the object references are relative to
+          references - Distinct references to resolve
+
+Outputs:  oid of every reference, -1 if not found
+------------------------------------------------------------------------------*/
+static void resolveViewOidsByName(TCHAR * itemReference, VIEW_OID_REFERENCE ** references, UNSIGNED32 numReferences)
+{
+    UNSIGNED32 temp;
+
+    for(temp = 0; temp < numReferences; temp++)
+        references[temp]->oid = GetOidFromFullQualifiedRefName(itemReference, references[temp]->objReference);
+}
+
+/*------------------------------------------------------------------------------
+Module:   InitViewOidBatch method
+
+Purpose:  Prepares an empty batch of object references
+
+Inputs:   oidBatch - batch to initialize
+
+Outputs:  Returns OK if successful
+------------------------------------------------------------------------------*/
+ERROR_STATUS InitViewOidBatch(VIEW_OID_BATCH * oidBatch)
+{
+    OSmemset(oidBatch, 0, sizeof(VIEW_OID_BATCH));
+
+    //Hash list to store the ASCII object reference and its batch entry
+    if((oidBatch->referenceHash = hashtbl_create(VIEW_OID_CONV_GROW_SIZE, HASH_TYPE_STR)) == NULL)
+        return HASH_CREATE_ERROR;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   DeferViewOid method
+
+Purpose:  Records an object reference and the ObjectOID field to fill with its oid.
+          The field is set to -1 until the batch is resolved.
+          On error nothing is recorded and the batch stays valid, the caller still
+          releases it with ReleaseViewOidBatch.
+
+Inputs:   oidBatch - batch to record the reference in
+          objReference - ASCII object reference from the JSON view, must stay valid
+                         until the batch is resolved
+          oidSlot - ObjectOID field of the reference
+
+Outputs:  Returns OK if successful
+------------------------------------------------------------------------------*/
+ERROR_STATUS DeferViewOid(VIEW_OID_BATCH * oidBatch, const SIGNED8 * objReference, OID_TYPE * oidSlot)
+{
+    VIEW_OID_REFERENCE * reference = NULL;
+    VIEW_OID_REFERENCE ** references;
+    VIEW_OID_SLOT * slots;
+    UNSIGNED16 keyLength;
+    ERROR_STATUS status;
+
+    *oidSlot = (OID_TYPE)-1;
+
+    if(objReference == NULL)
+        return ERROR_RESPONSE;
+
+    //Key is the ASCII reference with its terminator
+    for(keyLength = 0; objReference[keyLength] != 0; keyLength++)
+        ;
+    keyLength++;
+
+    //Step - 1: Room for the field to fill, so a reference is never added without its field
+    if(oidBatch->numSlots == oidBatch->maxSlots)
+    {
+        slots = (VIEW_OID_SLOT *)OSacquire(sizeof(VIEW_OID_SLOT) * (oidBatch->maxSlots + VIEW_OID_BATCH_GROW_SIZE));
+        if(slots == NULL)
+            return NOT_ENOUGH_MEMORY;
+
+        if(oidBatch->slots != NULL)
+        {
+            OSmemcpy(slots, oidBatch->slots, sizeof(VIEW_OID_SLOT) * oidBatch->numSlots);
+            OSrelease(oidBatch->slots);
+        }
+
+        oidBatch->slots = slots;
+        oidBatch->maxSlots += VIEW_OID_BATCH_GROW_SIZE;
+    }
+
+    //Step - 2: Find the reference or add it
+    if(hashtbl_get(oidBatch->referenceHash, (hashKey *)objReference, keyLength, (void **)&reference))
+    {
+        if(oidBatch->numReferences == oidBatch->maxReferences)
+        {
+            references = (VIEW_OID_REFERENCE **)OSacquire(sizeof(VIEW_OID_REFERENCE *) * (oidBatch->maxReferences + VIEW_OID_BATCH_GROW_SIZE));
+            if(references == NULL)
+                return NOT_ENOUGH_MEMORY;
+
+            if(oidBatch->references != NULL)
+            {
+                OSmemcpy(references, oidBatch->references, sizeof(VIEW_OID_REFERENCE *) * oidBatch->numReferences);
+                OSrelease(oidBatch->references);
+            }
+
+            oidBatch->references = references;
+            oidBatch->maxReferences += VIEW_OID_BATCH_GROW_SIZE;
+        }
+
+        reference = (VIEW_OID_REFERENCE *)OSacquire(sizeof(VIEW_OID_REFERENCE));
+        if(reference == NULL)
+            return NOT_ENOUGH_MEMORY;
+
+        reference->objReference = objReference;
+        reference->oid = (OID_TYPE)-1;
+
+        status = hashtbl_insert(oidBatch->referenceHash, (hashKey *)objReference, reference, keyLength);
+        if(status != OK)
+        {
+            OSrelease(reference);
+            return status;
+        }
+
+        oidBatch->references[oidBatch->numReferences++] = reference;
+    }
+
+    //Step - 3: Record the field to fill
+    oidBatch->slots[oidBatch->numSlots].reference = reference;
+    oidBatch->slots[oidBatch->numSlots].oidSlot = oidSlot;
+    oidBatch->numSlots++;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   ResolveViewOidBatch method
+
+Purpose:  Resolves every distinct reference of the batch with one call to the
+          resolver, then fills all the recorded ObjectOID fields.
+
+Inputs:   oidBatch - batch to resolve
+          itemReference - Item reference the object references are relative to
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+void ResolveViewOidBatch(VIEW_OID_BATCH * oidBatch, TCHAR * itemReference)
+{
+    UNSIGNED32 temp;
+
+    if(oidBatch->numReferences > 0)
+        viewOidResolver(itemReference, oidBatch->references, oidBatch->numReferences);
+
+    for(temp = 0; temp < oidBatch->numSlots; temp++)
+        *oidBatch->slots[temp].oidSlot = oidBatch->slots[temp].reference->oid;
+}
+
+/*------------------------------------------------------------------------------
+Module:   ReleaseViewOidBatch method
+
+Purpose:  Releases the memory held by a batch. Callers release the batch on every
+          exit, also when InitViewOidBatch or DeferViewOid failed.
+
+Inputs:   oidBatch - batch to release
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+void ReleaseViewOidBatch(VIEW_OID_BATCH * oidBatch)
+{
+    UNSIGNED32 temp;
+
+    for(temp = 0; temp < oidBatch->numReferences; temp++)
+        OSrelease(oidBatch->references[temp]);
+
+    if(oidBatch->references != NULL)
+        OSrelease(oidBatch->references);
+
+    if(oidBatch->slots != NULL)
+        OSrelease(oidBatch->slots);
+
+    if(oidBatch->referenceHash != NULL)
+        hashtbl_destroy(oidBatch->referenceHash);
+
+    OSmemset(oidBatch, 0, sizeof(VIEW_OID_BATCH));
+}
+
+/*------------------------------------------------------------------------------
+Module:   SetViewOidResolver method
+
+Purpose:  Replaces the resolver used for the object references of the views, e.g. by
+          a bulk resolver or by a local stand-in when there is no object database.
+
+Inputs:   resolver - new resolver, NULL restores the default one
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+void SetViewOidResolver(VIEW_OID_RESOLVER resolver)
+{
+    viewOidResolver = (resolver != NULL) ? resolver : resolveViewOidsByName;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getItemOidCache method
+
+Purpose:  Returns the oid cache of an item reference. The item cache of the previous
+          lookup is checked first, the views of an equipment all use the same item
+          reference so the item hash is rarely searched.
+
+Inputs:   viewDbExt - view database
+          itemReference - item reference
+          create - TRUE to create the item cache if there is none
+
+Outputs:  Item cache, NULL if there is none (or it could not be created)
+------------------------------------------------------------------------------*/
+static VIEW_ITEM_OID_CACHE * getItemOidCache(VIEW_DATABASE_EXT * viewDbExt, TCHAR * itemReference, UNSIGNED8 create)
+{
+    VIEW_ITEM_OID_CACHE * itemCache = NULL;
+    UNSIGNED16 keyLength;
+
+    if(viewDbExt->lastItemOidCache != NULL && OSstrcmp(viewDbExt->lastItemOidCache->itemReference, itemReference) == 0)
+        return viewDbExt->lastItemOidCache;
+
+    if(viewDbExt->itemOidHash == NULL)
+    {
+        if(create == FALSE)
+            return NULL;
+
+        //Hash list to store the item reference and its oid cache
+        if((viewDbExt->itemOidHash = hashtbl_create(VIEW_ITEM_OID_GROW_SIZE, HASH_TYPE_STR)) == NULL)
+            return NULL;
+    }
+
+    keyLength = STR_STORE(OSstrlen(itemReference));
+
+    if(hashtbl_get(viewDbExt->itemOidHash, (hashKey *)itemReference, keyLength, (void **)&itemCache))
+    {
+        if(create == FALSE)
+            return NULL;
+
+        itemCache = (VIEW_ITEM_OID_CACHE *)OSacquire(sizeof(VIEW_ITEM_OID_CACHE));
+        if(itemCache == NULL)
+            return NULL;
+
+        itemCache->itemReference = (TCHAR *)OSacquire(keyLength);
+        itemCache->objectOidHash = hashtbl_create(VIEW_OID_CONV_GROW_SIZE, HASH_TYPE_STR);
+        if(itemCache->itemReference == NULL || itemCache->objectOidHash == NULL ||
+            hashtbl_insert(viewDbExt->itemOidHash, (hashKey *)itemReference, itemCache, keyLength) != OK)
+        {
+            if(itemCache->itemReference != NULL)
+                OSrelease(itemCache->itemReference);
+            if(itemCache->objectOidHash != NULL)
+                hashtbl_destroy(itemCache->objectOidHash);
+            OSrelease(itemCache);
+            return NULL;
+        }
+
+        OSmemcpy(itemCache->itemReference, itemReference, keyLength);
+    }
+
+    viewDbExt->lastItemOidCache = itemCache;
+
+    return itemCache;
+}
+
+/*------------------------------------------------------------------------------
+Module:   FindItemOid method
+
+Purpose:  Looks an object reference up in the oid cache of its item reference.
+          Only the object reference is hashed and nothing is allocated.
+
+Inputs:   viewDb - view database
+          itemReference - item reference
+          objReference - ASCII object reference (as passed to the name lookup)
+
+Outputs:  Pointer to the cached oid, NULL if it is not cached
+------------------------------------------------------------------------------*/
+OID_TYPE * FindItemOid(VIEW_DATABASE * viewDb, TCHAR * itemReference, const SIGNED8 * objReference)
+{
+    VIEW_DATABASE_EXT * viewDbExt = (VIEW_DATABASE_EXT *)viewDb;
+    VIEW_ITEM_OID_CACHE * itemCache;
+    OID_TYPE * oid = NULL;
+    UNSIGNED16 keyLength;
+
+    itemCache = getItemOidCache(viewDbExt, itemReference, FALSE);
+    if(itemCache != NULL)
+    {
+        for(keyLength = 0; objReference[keyLength] != 0; keyLength++)
+            ;
+        keyLength++;
+
+        if(hashtbl_get(itemCache->objectOidHash, (hashKey *)objReference, keyLength, (void **)&oid))
+            oid = NULL;
+    }
+
+    if(oid != NULL)
+        viewDbExt->oidCacheHits++;
+    else
+        viewDbExt->oidCacheMisses++;
+
+    return oid;
+}
+
+/*------------------------------------------------------------------------------
+Module:   AddItemOid method
+
+Purpose:  Adds a resolved oid to the oid cache of its item reference
+
+Inputs:   viewDb - view database
+          itemReference - item reference
+          objReference - ASCII object reference (as passed to the name lookup)
+          oidVal - resolved oid
+
+Outputs:  ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS AddItemOid(VIEW_DATABASE * viewDb, TCHAR * itemReference, const SIGNED8 * objReference, OID_TYPE oidVal)
+{
+    VIEW_ITEM_OID_CACHE * itemCache;
+    OID_TYPE * oid;
+    UNSIGNED16 keyLength;
+    ERROR_STATUS status;
+
+    itemCache = getItemOidCache((VIEW_DATABASE_EXT *)viewDb, itemReference, TRUE);
+    if(itemCache == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    oid = (OID_TYPE *)OSacquire(sizeof(OID_TYPE));
+    if(oid == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    *oid = oidVal;
+
+    for(keyLength = 0; objReference[keyLength] != 0; keyLength++)
+        ;
+    keyLength++;
+
+    status = hashtbl_insert(itemCache->objectOidHash, (hashKey *)objReference, oid, keyLength);
+    if(status != OK)
+        OSrelease(oid);
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetViewOidCacheStats method
+
+Purpose:  Returns the number of oid cache hits and misses of the name lookups since
+          the view database was created. Used to measure the oid cache.
+
+Inputs:   NA
+
+Outputs:  hits, misses
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetViewOidCacheStats(UNSIGNED32 * hits, UNSIGNED32 * misses)
+{
+    VIEW_DATABASE_EXT * viewDbExt;
+    MODEL_CLASS_VARS *classVarPtr;
+
+    // get ptr to the model's class vars
+    classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+    viewDbExt = (VIEW_DATABASE_EXT *)classVarPtr->view_database;
+    if(viewDbExt == NULL)
+        return VIEW_DATABASE_NOT_FOUND;
+
+    *hits = viewDbExt->oidCacheHits;
+    *misses = viewDbExt->oidCacheMisses;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   oidCacheChecksum method
+
+Purpose:  Cheap running checksum of the cache payload, enough to reject a torn or
+          corrupted cache file.
+
+Inputs:   data - Bytes to add
+          length - Number of bytes
+
+Outputs:  Checksum
+------------------------------------------------------------------------------*/
+static UNSIGNED32 oidCacheChecksum(const UNSIGNED8 * data, UNSIGNED32 length)
+{
+    UNSIGNED32 sum1 = 0xFFFF, sum2 = 0xFFFF;
+
+    while(length--)
+    {
+        sum1 = (sum1 + *data++) % 65521;
+        sum2 = (sum2 + sum1) % 65521;
+    }
+
+    return (sum2 << 16) | sum1;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getViewOidCachePath method
+
+Purpose:  Returns the path of the oid cache file: the view file path (same as
+          ReadViewFile) + VIEW_OID_CACHE_SUFFIX.
+
+Inputs:   NA
+
+Outputs:  cachePath - Caller is responsible for releasing it.
+------------------------------------------------------------------------------*/
+static ERROR_STATUS getViewOidCachePath(TCHAR ** cachePath)
+{
+    PARM_DATA  TemplatePathParm, viewParm;
+    TCHAR * pTemplatePath;
+    TCHAR * pViewFilename;
+    TCHAR * path;
+    UNSIGNED16 pathSize;
+
+    //Read the View path - This is same as the template path
+    oreGetMyResource(RID_DATA_MODEL_TEMPLATE_PATH, &TemplatePathParm);
+    pTemplatePath = (TCHAR*)TemplatePathParm.parmValue.tString.strPtr;
+
+    //Read the View Name from the resource.
+    oreGetMyResource(RID_DATA_MODEL_VIEW_DEF, &viewParm);
+    pViewFilename = (TCHAR*)viewParm.parmValue.tString.strPtr;
+
+    if(pTemplatePath == NULL || pViewFilename == NULL)
+    {
+        apsReleaseParm(&TemplatePathParm);
+        apsReleaseParm(&viewParm);
+        return ERROR_RESPONSE;
+    }
+
+    pathSize = STR_STORE(OSstrlen(pTemplatePath) + OSstrlen(pViewFilename) + OSstrlen(VIEW_OID_CACHE_SUFFIX));
+    path = (TCHAR *)OSacquire(pathSize);
+    if(path != NULL)
+    {
+        OSmemset(path, 0, pathSize);
+        OSstrcpy(path, pTemplatePath);
+        OSstrcat(path, pViewFilename);
+        OSstrcat(path, VIEW_OID_CACHE_SUFFIX);
+    }
+
+    apsReleaseParm(&TemplatePathParm);
+    apsReleaseParm(&viewParm);
+
+    if(path == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    *cachePath = path;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   oidCacheKeyMatches method
+
+Purpose:  Checks a string of the cache payload (UNSIGNED16 length, then the
+          characters and the terminator) against an expected string and steps past it.
+
+Inputs:   payload, payloadSize - cache payload
+          position - offset of the string
+          expected - expected string, NULL stands for an empty string
+
+Outputs:  position - offset past the string
+          TRUE if the string matches
+------------------------------------------------------------------------------*/
+static UNSIGNED8 oidCacheKeyMatches(const UNSIGNED8 * payload, UNSIGNED32 payloadSize, UNSIGNED32 * position, TCHAR * expected)
+{
+    UNSIGNED16 length, expectedLength;
+    TCHAR empty = 0;
+
+    if(expected == NULL)
+        expected = &empty;
+
+    if(*position + sizeof(UNSIGNED16) > payloadSize)
+        return FALSE;
+
+    OSmemcpy(&length, payload + *position, sizeof(UNSIGNED16));
+    *position += sizeof(UNSIGNED16);
+
+    if(*position + STR_STORE(length) > payloadSize)
+        return FALSE;
+
+    expectedLength = OSstrlen(expected);
+    if(length != expectedLength || OSmemcmp(payload + *position, expected, STR_STORE(length)) != 0)
+        return FALSE;
+
+    *position += STR_STORE(length);
+
+    return TRUE;
+}
+
+/*------------------------------------------------------------------------------
+Module:   oidCacheNextEntry method
+
+Purpose:  Steps past an entry of the cache payload: oid, UNSIGNED16 length, then the
+          full qualified reference name with its terminator.
+
+Inputs:   payload, payloadSize - cache payload
+          position - offset of the entry
+
+Outputs:  position - offset past the entry
+          oid - oid of the entry
+          Returns the offset of the reference name, 0 if the entry is cut off
+------------------------------------------------------------------------------*/
+static UNSIGNED32 oidCacheNextEntry(const UNSIGNED8 * payload, UNSIGNED32 payloadSize, UNSIGNED32 * position, OID_TYPE * oid)
+{
+    UNSIGNED32 name;
+    UNSIGNED16 length;
+
+    if(*position + sizeof(OID_TYPE) + sizeof(UNSIGNED16) > payloadSize)
+        return 0;
+
+    OSmemcpy(oid, payload + *position, sizeof(OID_TYPE));
+    OSmemcpy(&length, payload + *position + sizeof(OID_TYPE), sizeof(UNSIGNED16));
+    name = *position + sizeof(OID_TYPE) + sizeof(UNSIGNED16);
+
+    if(name + STR_STORE(length) > payloadSize)
+        return 0;
+
+    *position = name + STR_STORE(length);
+
+    return name;
+}
+
+/*------------------------------------------------------------------------------
+Module:   LoadViewOidCache method
+
+Purpose:  Pre-populates oidHash from the oid cache file. The cache is only used
+          when it was written by this firmware for the same view version, item
+          reference and template version, its payload checksum is right and the
+          VIEW_OID_CACHE_PROBES entries opened by name again still resolve to their
+          cached oids.
+
+Inputs:   viewDb - view database whose oidHash is filled
+          viewVersion - Version of the view file
+          itemReference - Item reference the views are initialized for
+          templateVersion - Version of the template file the objects were created from
+
+Outputs:  stamp - What the file holds, empty if the cache was not usable
+          Returns OK if the cache was loaded
+------------------------------------------------------------------------------*/
+ERROR_STATUS LoadViewOidCache(VIEW_DATABASE * viewDb, TCHAR * viewVersion, TCHAR * itemReference, TCHAR * templateVersion, VIEW_OID_CACHE_STAMP * stamp)
+{
+    VIEW_OID_CACHE_HEADER header;
+    TCHAR rb_filemode[] = {(TCHAR)'r', (TCHAR)'b', (TCHAR)'\0'};
+    TCHAR * cachePath = NULL;
+    UNSIGNED8 * payload;
+    UNSIGNED32 probes[VIEW_OID_CACHE_PROBES];
+    UNSIGNED32 position = 0, entries, entry, name, start, digest = 0;
+    UNSIGNED16 numProbes = 0, probe;
+    OID_TYPE oidVal;
+    OID_TYPE * oid;
+    void * pFile;
+    ERROR_STATUS status;
+
+    OSmemset(stamp, 0, sizeof(VIEW_OID_CACHE_STAMP));
+
+    status = getViewOidCachePath(&cachePath);
+    if(status != OK)
+        return status;
+
+    pFile = OSFileOpen(cachePath, rb_filemode);
+    OSrelease(cachePath);
+
+    if(pFile == NULL)
+        return FILE_NOT_FOUND;
+
+    //Check the header before reading the payload
+    if(OSFileRead(&header, sizeof(UNSIGNED8), sizeof(header), pFile) != sizeof(header) ||
+        header.magic != VIEW_OID_CACHE_MAGIC ||
+        header.cacheVersion != VIEW_OID_CACHE_VERSION ||
+        header.oidSize != sizeof(OID_TYPE))
+    {
+        OSFileClose(pFile);
+        return ERROR_RESPONSE;
+    }
+
+    payload = (UNSIGNED8 *)OSacquire(header.payloadSize);
+    if(payload == NULL)
+    {
+        OSFileClose(pFile);
+        return NOT_ENOUGH_MEMORY;
+    }
+
+    if(OSFileRead(payload, sizeof(UNSIGNED8), header.payloadSize, pFile) != header.payloadSize ||
+        oidCacheChecksum(payload, header.payloadSize) != header.payloadChecksum)
+        status = ERROR_RESPONSE;
+
+    OSFileClose(pFile);
+
+    //Step - 1: Key - view version, item reference and template version
+    if(status == OK &&
+        (oidCacheKeyMatches(payload, header.payloadSize, &position, viewVersion) == FALSE ||
+         oidCacheKeyMatches(payload, header.payloadSize, &position, itemReference) == FALSE ||
+         oidCacheKeyMatches(payload, header.payloadSize, &position, templateVersion) == FALSE))
+        status = ERROR_RESPONSE;
+
+    //Step - 2: Walk the entries, pick the ones to probe spread over the file
+    entries = position;
+    for(entry = 0; status == OK && entry < header.entryCount; entry++)
+    {
+        start = position;
+        if(oidCacheNextEntry(payload, header.payloadSize, &position, &oidVal) == 0)
+        {
+            status = ERROR_RESPONSE;
+            break;
+        }
+
+        digest += oidCacheChecksum(payload + start, position - start);
+
+        if(numProbes < VIEW_OID_CACHE_PROBES && entry >= (UNSIGNED32)numProbes * header.entryCount / VIEW_OID_CACHE_PROBES)
+            probes[numProbes++] = start;
+    }
+
+    //Step - 3: The objects must still resolve to the cached oids
+    for(probe = 0; status == OK && probe < numProbes; probe++)
+    {
+        position = probes[probe];
+        name = oidCacheNextEntry(payload, header.payloadSize, &position, &oidVal);
+
+        if(OpenViewOidByName((TCHAR *)(payload + name)) != oidVal)
+            status = ERROR_RESPONSE;
+    }
+
+    //Step - 4: Entries into oidHash, same key as GetOidFromFullQualifiedRefName uses
+    position = entries;
+    for(entry = 0; status == OK && entry < header.entryCount; entry++)
+    {
+        name = oidCacheNextEntry(payload, header.payloadSize, &position, &oidVal);
+
+        oid = (OID_TYPE *)OSacquire(sizeof(OID_TYPE));
+        if(oid == NULL)
+        {
+            status = NOT_ENOUGH_MEMORY;
+            break;
+        }
+
+        *oid = oidVal;
+
+        if(hashtbl_insert(viewDb->oidHash, (hashKey *)(payload + name), oid, (UNSIGNED16)(position - name)) == OK)
+            stamp->entryCount++;
+        else
+            OSrelease(oid);
+    }
+
+    //Anything short of the whole file makes the next save write it again
+    if(status == OK && stamp->entryCount == header.entryCount)
+        stamp->digest = digest;
+    else
+        stamp->entryCount = 0;
+
+    OSrelease(payload);
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   oidCachePutString method
+
+Purpose:  Appends a string to the cache payload: UNSIGNED16 length, then the
+          characters and the terminator.
+
+Inputs:   payload - cache payload, NULL to only size the string
+          string - string to append, NULL stands for an empty string
+
+Outputs:  position - offset past the string
+------------------------------------------------------------------------------*/
+static void oidCachePutString(UNSIGNED8 * payload, UNSIGNED32 * position, TCHAR * string)
+{
+    UNSIGNED16 length;
+    TCHAR empty = 0;
+
+    if(string == NULL)
+        string = &empty;
+
+    length = OSstrlen(string);
+
+    if(payload != NULL)
+    {
+        OSmemcpy(payload + *position, &length, sizeof(UNSIGNED16));
+        OSmemcpy(payload + *position + sizeof(UNSIGNED16), string, STR_STORE(length));
+    }
+
+    *position += sizeof(UNSIGNED16) + STR_STORE(length);
+}
+
+/*------------------------------------------------------------------------------
+Module:   SaveViewOidCache method
+
+Purpose:  Writes the resolved oids of oidHash to the oid cache file. References
+          that could not be resolved are left out so they are tried again on the
+          next start. Nothing is written when the oids are the ones the file
+          already holds; any oid added, dropped or resolved differently writes it.
+
+Inputs:   viewDb - view database whose oidHash is saved
+          viewVersion - Version of the view file
+          itemReference - Item reference the views were initialized for
+          templateVersion - Version of the template file the objects were created from
+          stamp - What the file holds (from LoadViewOidCache or the previous save)
+
+Outputs:  stamp - Updated once the file is written
+          ERROR_STATUS
+------------------------------------------------------------------------------*/
+ERROR_STATUS SaveViewOidCache(VIEW_DATABASE * viewDb, TCHAR * viewVersion, TCHAR * itemReference, TCHAR * templateVersion, VIEW_OID_CACHE_STAMP * stamp)
+{
+    VIEW_OID_CACHE_HEADER header;
+    TCHAR wb_filemode[] = {(TCHAR)'w', (TCHAR)'b', (TCHAR)'\0'};
+    TCHAR * cachePath = NULL;
+    struct hashEntry_s * node;
+    UNSIGNED8 * payload = NULL;
+    UNSIGNED32 position = 0, entryCount = 0, digest = 0, pass;
+    UNSIGNED16 bucket, length;
+    void * pFile;
+    ERROR_STATUS status = OK;
+
+    //Pass 0 sizes the payload and checks it against the file, pass 1 fills it
+    for(pass = 0; pass < 2; pass++)
+    {
+        position = 0;
+        entryCount = 0;
+
+        oidCachePutString(payload, &position, viewVersion);
+        oidCachePutString(payload, &position, itemReference);
+        oidCachePutString(payload, &position, templateVersion);
+
+        for(bucket = 0; bucket < viewDb->oidHash->size; bucket++)
+        {
+            for(node = viewDb->oidHash->nodes[bucket]; node != NULL; node = node->next)
+            {
+                if(*(OID_TYPE *)node->data == (OID_TYPE)-1)
+                    continue;
+
+                if(payload != NULL)
+                {
+                    length = (UNSIGNED16)(node->keyLen / sizeof(TCHAR) - 1);
+                    OSmemcpy(payload + position, node->data, sizeof(OID_TYPE));
+                    OSmemcpy(payload + position + sizeof(OID_TYPE), &length, sizeof(UNSIGNED16));
+                    OSmemcpy(payload + position + sizeof(OID_TYPE) + sizeof(UNSIGNED16), node->key, node->keyLen);
+
+                    digest += oidCacheChecksum(payload + position, sizeof(OID_TYPE) + sizeof(UNSIGNED16) + node->keyLen);
+                }
+
+                position += sizeof(OID_TYPE) + sizeof(UNSIGNED16) + node->keyLen;
+                entryCount++;
+            }
+        }
+
+        if(pass == 0)
+        {
+            //Same number of entries - compare the content once it is laid out
+            if(entryCount == 0 && stamp->entryCount == 0)
+                return OK;
+
+            payload = (UNSIGNED8 *)OSacquire(position);
+            if(payload == NULL)
+                return NOT_ENOUGH_MEMORY;
+        }
+    }
+
+    if(entryCount == stamp->entryCount && digest == stamp->digest)
+    {
+        OSrelease(payload);
+        return OK;
+    }
+
+    header.magic = VIEW_OID_CACHE_MAGIC;
+    header.cacheVersion = VIEW_OID_CACHE_VERSION;
+    header.oidSize = sizeof(OID_TYPE);
+    header.entryCount = entryCount;
+    header.payloadSize = position;
+    header.payloadChecksum = oidCacheChecksum(payload, position);
+
+    status = getViewOidCachePath(&cachePath);
+    if(status == OK)
+    {
+        pFile = OSFileOpen(cachePath, wb_filemode);
+        if(pFile == NULL)
+        {
+            status = FILE_NOT_FOUND;
+        }
+        else
+        {
+            if(OSFileWrite(&header, sizeof(UNSIGNED8), sizeof(header), pFile) != sizeof(header) ||
+                OSFileWrite(payload, sizeof(UNSIGNED8), position, pFile) != position)
+                status = ERROR_RESPONSE;
+
+            OSFileClose(pFile);
+        }
+
+        OSrelease(cachePath);
+    }
+
+    OSrelease(payload);
+
+    if(status == OK)
+    {
+        stamp->entryCount = entryCount;
+        stamp->digest = digest;
+    }
+
+    return status;
+}
@@ -15,10 +15,78 @@ Outputs:  ERROR_STATUS returned if on any issue.
 ------------------------------------------------------------------------------*/
 #include <view_api.h>
 #include <view_api_private.h>
+#include "view_ext_private.h"
 #include <uniStr.h>
 #include <unit.h>
 #include <apsserv.h>
 
+//Element type of a "link" element, only told apart while filling the data points
+#define VIEW_LINK_ELEMENT_TYPE      0xFF
+
+//Enumerated string fields of the JSON view are matched on their ASCII value against
+//these tables, so no Unicode copy of the value is needed
+typedef struct
+{
+    const SIGNED8 * keyword;
+    UNSIGNED8 value;
+} VIEW_KEYWORD;
+
+static const VIEW_KEYWORD viewElementTypeKeywords[] =
+{
+    { "group", GROUP_ELEMENT_TYPE },
+    { "link",  VIEW_LINK_ELEMENT_TYPE }
+};
+
+static const VIEW_KEYWORD viewOperatorKeywords[] =
+{
+    { "equal",        PIOPERATOR_EQUAL },
+    { "not equal",    PIOPERATOR_NOTEQUAL },
+    { "greater than", PIOPERATOR_GREATER },
+    { "less than",    PIOPERATOR_LESSER }
+};
+
+#define VIEW_KEYWORD_COUNT(keywords)    ((UNSIGNED16)(sizeof(keywords) / sizeof((keywords)[0])))
+
+/*------------------------------------------------------------------------------
+Module:   lookupViewKeyword method
+
+Purpose:  Maps the ASCII value of an enumerated field of the JSON view to its value
+          from a keyword table.
+
+Inputs:   asciiValue - ASCII string value of the field, may be NULL
+          keywords - keyword table
+          numKeywords - Number of entries in the table
+          notFound - Value returned when no keyword matches
+
+Outputs:  Value of the matching keyword, notFound otherwise
+------------------------------------------------------------------------------*/
+static UNSIGNED8 lookupViewKeyword(const SIGNED8 * asciiValue, const VIEW_KEYWORD * keywords, UNSIGNED16 numKeywords, UNSIGNED8 notFound)
+{
+    const SIGNED8 * keyword;
+    const SIGNED8 * value;
+    UNSIGNED16 temp;
+
+    if(asciiValue == NULL)
+        return notFound;
+
+    for(temp = 0; temp < numKeywords; temp++)
+    {
+        keyword = keywords[temp].keyword;
+        value = asciiValue;
+
+        while(*keyword != '\0' && *keyword == *value)
+        {
+            keyword++;
+            value++;
+        }
+
+        if(*keyword == '\0' && *value == '\0')
+            return keywords[temp].value;
+    }
+
+    return notFound;
+}
+
 
 /*------------------------------------------------------------------------------
 Module:   GetTemplateFromJSONView method
@@ -86,26 +154,24 @@ ERROR_STATUS ParseViewJSON(SIGNED8 * buffer, json_t ** jsonObject)
 /*------------------------------------------------------------------------------
 Module:   View Interface
 
-Purpose:  This should be responsible to add menu group pointer to menu Group
+Purpose:  This should be responsible to fill the menu group pointer of a group element:
+label, short label, group handle, presence indicator and type minor
 
-Method:   AddMenuGroupPointerToMenuGroup
+Method:   FillMenuGroupPointer
 
-Inputs:   menuGroup: Reference to menuGroup to which a new group to be added.
-menuElementIndex - MenuElementIndex to insert this menuElement
+Inputs:   menuGroup: Reference to menuGroup holding the group element
+menuElementIndex - MenuElementIndex of the group element
 jsonGroupObj: Pointer to json Object - Need this to fetch label enum and label set
-grpHandle: Holds the current group handle Ex: 1001
-itemReference: Reference to the current item Reference (Need this to pull oid from itemReference for value Elements)	  
+grpHandle: Group handle to use if the group has no "id" Ex: 1001
+itemReference: Reference to the current item Reference (Need this to pull oid for the presence indicator)
+oidBatch: Batch to defer the presence indicator oid to, NULL to resolve it now
 
-Outputs:  newMenuGroup - Returns new Menu Group pointer for a given menu group.
-ERROR_STATUS returned if on any issue.
+Outputs:  ERROR_STATUS returned if on any issue.
 ------------------------------------------------------------------------------*/
-ERROR_STATUS AddMenuGroupPointerToMenuGroup(MenuGroup * menuGroup, json_t * jsonGroupObj, UNSIGNED16 menuElementIndex, UNSIGNED16 * grpHandle, TCHAR * itemReference, MenuGroup ** newMenuGroup)
+ERROR_STATUS FillMenuGroupPointer(MenuGroup * menuGroup, json_t * jsonGroupObj, UNSIGNED16 menuElementIndex, UNSIGNED16 grpHandle, TCHAR * itemReference, VIEW_OID_BATCH * oidBatch)
 {
     ERROR_STATUS status = OK;
-    MenuGroupPointer * menuGrpPointer = NULL;
-    json_t *jsonlabelObject, *jsonshortLabelObject, *jsonTempObj, *jsonGrpIdObj, *jsonGrpElementArray, *jsonGrpPresenceIndicator, *jsonTypeMinor;
-    UNSIGNED16 grpElementsCount, groupSize = 0;
-    MenuGroup *newmenuGroupElement = NULL;
+    json_t *jsonlabelObject, *jsonshortLabelObject, *jsonTempObj, *jsonGrpIdObj, *jsonGrpPresenceIndicator, *jsonTypeMinor;
 
 
     //Step - 1 : Read label element
@@ -158,14 +224,14 @@ ERROR_STATUS AddMenuGroupPointerToMenuGroup(MenuGroup * menuGroup, json_t * json
     else
     {
         //GroupID do not exist, add groupHandle number to menuGrpPointer
-        menuGroup->groupElements[menuElementIndex].Group.GroupHandle = *grpHandle;
+        menuGroup->groupElements[menuElementIndex].Group.GroupHandle = grpHandle;
     }
 
     //Step - 3 - Check for Presense Indicator
     getJSONObjectForKey(jsonGroupObj, _T("presenceIndicator"), &jsonGrpPresenceIndicator);
     if(jsonGrpPresenceIndicator != NULL)
     {
-        status = FillPresenceIndicator(jsonGrpPresenceIndicator, menuElementIndex, itemReference, menuGroup);
+        status = FillPresenceIndicatorDeferred(jsonGrpPresenceIndicator, menuElementIndex, itemReference, menuGroup, oidBatch);
         if(status != OK)
             return ERROR_RESPONSE;
     }
@@ -179,6 +245,36 @@ ERROR_STATUS AddMenuGroupPointerToMenuGroup(MenuGroup * menuGroup, json_t * json
             menuGroup->groupElements[menuElementIndex].Group.TypeMinor = TRUE;
     }
 
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   View Interface
+
+Purpose:  This should be responsible to add menu group pointer to menu Group
+
+Method:   AddMenuGroupPointerToMenuGroup
+
+Inputs:   menuGroup: Reference to menuGroup to which a new group to be added.
+menuElementIndex - MenuElementIndex to insert this menuElement
+jsonGroupObj: Pointer to json Object - Need this to fetch label enum and label set
+grpHandle: Holds the current group handle Ex: 1001
+itemReference: Reference to the current item Reference (Need this to pull oid from itemReference for value Elements)	  
+
+Outputs:  newMenuGroup - Returns new Menu Group pointer for a given menu group.
+ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+ERROR_STATUS AddMenuGroupPointerToMenuGroup(MenuGroup * menuGroup, json_t * jsonGroupObj, UNSIGNED16 menuElementIndex, UNSIGNED16 * grpHandle, TCHAR * itemReference, MenuGroup ** newMenuGroup)
+{
+    ERROR_STATUS status = OK;
+    json_t *jsonGrpElementArray;
+    UNSIGNED16 grpElementsCount, groupSize = 0;
+    MenuGroup *newmenuGroupElement = NULL;
+
+    //Step - 1 to 4 Fill the menu group pointer
+    status = FillMenuGroupPointer(menuGroup, jsonGroupObj, menuElementIndex, *grpHandle, itemReference, NULL);
+    if(status != OK)
+        return status;
 
     //Step - 5 Allocate new MenuGroup for this group
     //Read the json element entries to obtain no. of elements
@@ -215,14 +311,27 @@ menuGroup : Reference to menuGroup to insert presence indicator data
 Outputs:  Returns OK with everything is Ok
 ------------------------------------------------------------------------------*/
 ERROR_STATUS FillPresenceIndicator(json_t * jsonGrpPresenceIndicator, UNSIGNED16 menuElementIndex, TCHAR * itemReference, MenuGroup * menuGroup)
+{
+    return FillPresenceIndicatorDeferred(jsonGrpPresenceIndicator, menuElementIndex, itemReference, menuGroup, NULL);
+}
+
+/*------------------------------------------------------------------------------
+Purpose:  Same as FillPresenceIndicator, the oid of an object reference is only
+          recorded in oidBatch when one is passed and filled in when the batch is resolved
+
+Method:   FillPresenceIndicatorDeferred
+
+Inputs:   oidBatch: Batch to defer the object reference to, NULL to resolve it now
+
+Outputs:  Returns OK with everything is Ok
+------------------------------------------------------------------------------*/
+ERROR_STATUS FillPresenceIndicatorDeferred(json_t * jsonGrpPresenceIndicator, UNSIGNED16 menuElementIndex, TCHAR * itemReference, MenuGroup * menuGroup, VIEW_OID_BATCH * oidBatch)
 {
     ERROR_STATUS status = OK;
     json_t * jsonvalueReference, *jsonTempObj, *jsonTempConstantObj;
     const SIGNED8 * objReference;
     const SIGNED8 * operatorReference;
     BAC_OID_CONVERT  bacOid = {0};
-
-    TCHAR *unicodeOperatorReference;
     OID_TYPE oid;
 
     //Read the json element entries and start parsing
@@ -243,9 +352,18 @@ ERROR_STATUS FillPresenceIndicator(json_t * jsonGrpPresenceIndicator, UNSIGNED16
     if(jsonTempObj != NULL)
     {
         objReference = json_string_value(jsonTempObj);			
-        oid = GetOidFromFullQualifiedRefName(itemReference, objReference);
+        if(oidBatch != NULL)
+        {
+            status = DeferViewOid(oidBatch, objReference, &menuGroup->groupElements[menuElementIndex].Group.piPoint.ObjectOID);
+            if(status != OK)
+                return status;
+        }
+        else
+        {
+            oid = GetOidFromFullQualifiedRefName(itemReference, objReference);
 
-        menuGroup->groupElements[menuElementIndex].Group.piPoint.ObjectOID = oid;
+            menuGroup->groupElements[menuElementIndex].Group.piPoint.ObjectOID = oid;
+        }
     }
     else
     {
@@ -264,35 +382,9 @@ ERROR_STATUS FillPresenceIndicator(json_t * jsonGrpPresenceIndicator, UNSIGNED16
     if(jsonTempObj == NULL)
         return ERROR_RESPONSE;
 
-    operatorReference = json_string_value(jsonTempObj);			
-    status = getUnicodeFromASCII(operatorReference, &unicodeOperatorReference);
-
-    if(status != OK)
-        return status;
-
-    if(!OSstrcmp(unicodeOperatorReference, _T("equal")))
-    {
-        menuGroup->groupElements[menuElementIndex].Group.piPoint.PIOperator = PIOPERATOR_EQUAL;
-    }
-    else if(!OSstrcmp(unicodeOperatorReference, _T("not equal")))
-    {
-        menuGroup->groupElements[menuElementIndex].Group.piPoint.PIOperator = PIOPERATOR_NOTEQUAL;
-    }
-    else if(!OSstrcmp(unicodeOperatorReference, _T("greater than")))
-    {
-        menuGroup->groupElements[menuElementIndex].Group.piPoint.PIOperator = PIOPERATOR_GREATER;
-    }
-    else if(!OSstrcmp(unicodeOperatorReference, _T("less than")))
-    {
-        menuGroup->groupElements[menuElementIndex].Group.piPoint.PIOperator = PIOPERATOR_LESSER;
-    }
-    else
-    {
-        menuGroup->groupElements[menuElementIndex].Group.piPoint.PIOperator = PIOPERATOR_NOT_FOUND;
-    }
-
-    //Release unicodeOperatorRef
-    OSrelease(unicodeOperatorReference);
+    operatorReference = json_string_value(jsonTempObj);
+    menuGroup->groupElements[menuElementIndex].Group.piPoint.PIOperator = lookupViewKeyword(operatorReference, viewOperatorKeywords,
+                                                                                            VIEW_KEYWORD_COUNT(viewOperatorKeywords), PIOPERATOR_NOT_FOUND);
 
     //Read Constant
     jsonTempObj = NULL;
@@ -333,7 +425,6 @@ ERROR_STATUS getGroupElementTypeCountAndElements(json_t * jsonGroupData, UNSIGNE
     UNSIGNED8 eType;
     UNSIGNED16 eCount;
     const SIGNED8 * elementIsGroupOrValue = NULL;
-    UNSIGNED16 * wideCharElementIsGroupOrValue = NULL;
     json_t * jsonElementArray, *jsonTempObj, *jsonViewElementType;
 
     //Read the json element entries and start parsing
@@ -362,11 +453,8 @@ ERROR_STATUS getGroupElementTypeCountAndElements(json_t * jsonGroupData, UNSIGNE
     if(elementIsGroupOrValue == NULL)
         return ERROR_RESPONSE;
 
-    status = getUnicodeFromASCII(elementIsGroupOrValue, &wideCharElementIsGroupOrValue);
-    eType = OSstrcmp(wideCharElementIsGroupOrValue, _T("group")) == 0 ? GROUP_ELEMENT_TYPE : VALUE_ELEMENT_TYPE;
-
-    //Release wideCharElement address
-    OSrelease(wideCharElementIsGroupOrValue);
+    eType = lookupViewKeyword(elementIsGroupOrValue, viewElementTypeKeywords, VIEW_KEYWORD_COUNT(viewElementTypeKeywords),
+                              VALUE_ELEMENT_TYPE) == GROUP_ELEMENT_TYPE ? GROUP_ELEMENT_TYPE : VALUE_ELEMENT_TYPE;
 
     *elementType = eType;
     *elementCount = eCount;
@@ -464,6 +552,37 @@ ERROR_STATUS AddNewMenuGroup(json_t * jsonGroupData, APSHASHTBL * viewGroupHash,
     return OK;	
 }
 
+/*------------------------------------------------------------------------------
+Purpose:  Opens a connection by name, without looking the name up in oidHash
+
+Method:   OpenViewOidByName
+
+Inputs:   fqrRef: Full qualified reference name (item reference + object reference)
+
+Outputs:  Returns oid, returns -1 if oid not found
+------------------------------------------------------------------------------*/
+OID_TYPE OpenViewOidByName(TCHAR * fqrRef)
+{
+    PARM_DATA pData;
+    UNSIGNED16 strLength = OSstrlen(fqrRef);
+    OID_TYPE oidVal;
+
+    pData.dataType = STRING_DATA_TYPE;
+    pData.parmValue.tString.strPtr = OSacquire(STR_STORE(strLength));
+    if(pData.parmValue.tString.strPtr == NULL)
+        return -1;
+
+    pData.parmValue.tString.strLen = strLength;
+    pData.parmValue.tString.releaseWhenDone = TRUE;
+    OSstrncpy(pData.parmValue.tString.strPtr, fqrRef, strLength);
+
+    oidVal = apsOpenConnectionByName(&pData);
+
+    apsReleaseParm(&pData);
+
+    return oidVal;
+}
+
 /*------------------------------------------------------------------------------
 Purpose:  This should be responsible to fetch oid for a given FQRN
 
@@ -476,7 +595,6 @@ Outputs:  Returns oid, returns -1 if oid not found
 ------------------------------------------------------------------------------*/
 OID_TYPE GetOidFromFullQualifiedRefName(TCHAR * itemReference, const SIGNED8 * objReference)
 {
-    PARM_DATA pData;
     TCHAR * unicodeObjRef = NULL;
     TCHAR * fqrRef = NULL;
     UNSIGNED16 strLength = 0;
@@ -493,6 +611,12 @@ OID_TYPE GetOidFromFullQualifiedRefName(TCHAR * itemReference, const SIGNED8 * o
 
     //objReference is signed8. Go Past the next address to get the data
     objReference++;
+
+    //Cache hit - no full qualified name needed
+    oid = FindItemOid(viewDb, itemReference, objReference);
+    if(oid != NULL)
+        return *oid;
+
     status = getUnicodeFromASCII(objReference, &unicodeObjRef);
     if(status != OK)
         return oidVal;
@@ -521,13 +645,11 @@ OID_TYPE GetOidFromFullQualifiedRefName(TCHAR * itemReference, const SIGNED8 * o
     else
     {
         //Not Found, Do apsOpenConnection and add to hash
-        pData.dataType = STRING_DATA_TYPE;
-        pData.parmValue.tString.strPtr = OSacquire(STR_STORE(strLength));
-        pData.parmValue.tString.strLen = strLength;
-        pData.parmValue.tString.releaseWhenDone = TRUE;
-        OSstrncpy(pData.parmValue.tString.strPtr, fqrRef, strLength);
+        oidVal = OpenViewOidByName(fqrRef);
 
-        oidVal = apsOpenConnectionByName(&pData);
+        //To be kept in the oid cache file
+        if(oidVal != (OID_TYPE)-1)
+            ((VIEW_DATABASE_EXT *)viewDb)->newOids++;
 
         //Acquire memory to store this data.
         oid = (OID_TYPE *)OSacquire(sizeof(OID_TYPE));
@@ -537,12 +659,13 @@ OID_TYPE GetOidFromFullQualifiedRefName(TCHAR * itemReference, const SIGNED8 * o
 
         //Insert oid reference with Oid number to hash
         hashtbl_insert(viewDb->oidHash, fqrRef, oid, STR_STORE(strLength));
-
-        apsReleaseParm(&pData);	
     }
 
     OSrelease(fqrRef);
 
+    //Next lookup of this reference is a cache hit
+    AddItemOid(viewDb, itemReference, objReference, oidVal);
+
     return oidVal;
 }
 
@@ -559,13 +682,27 @@ Inputs:   jsonElementArray: Reference to json object pointing to value element A
 Outputs:  Returns oid, returns -1 if oid not found
 ------------------------------------------------------------------------------*/
 ERROR_STATUS FillMenuDataPoints(json_t * jsonElementArray, MenuGroup * menuGroup, UNSIGNED16 numElements, TCHAR * itemReference)
+{
+    return FillMenuDataPointsDeferred(jsonElementArray, menuGroup, numElements, itemReference, NULL);
+}
+
+/*------------------------------------------------------------------------------
+Purpose:  Same as FillMenuDataPoints, the oids of object references are only
+          recorded in oidBatch when one is passed and filled in when the batch is resolved
+
+Method:   FillMenuDataPointsDeferred
+
+Inputs:   oidBatch: Batch to defer the object references to, NULL to resolve them now
+
+Outputs:  Returns OK with everything is Ok
+------------------------------------------------------------------------------*/
+ERROR_STATUS FillMenuDataPointsDeferred(json_t * jsonElementArray, MenuGroup * menuGroup, UNSIGNED16 numElements, TCHAR * itemReference, VIEW_OID_BATCH * oidBatch)
 {
     ERROR_STATUS status = OK;
     json_t *jsonlabelObject, *jsonshortLabelObject, *jsonTempObj, *jsonElementObj, *jsonValueRefObject, *jsonIgnorePresenceObject;
     UNSIGNED16 temp, bacoid = 0;
     OID_TYPE oid = 0;
     const SIGNED8 * objReference, *elementType;
-    TCHAR * uniElementType;
     BAC_OID_CONVERT  bacOid = {0};
 
     //Step - 1: Loop Through all the data elements in a group
@@ -581,8 +718,8 @@ ERROR_STATUS FillMenuDataPoints(json_t * jsonElementArray, MenuGroup * menuGroup
             return ERROR_RESPONSE;
 
         elementType = json_string_value(jsonTempObj);	
-        status = getUnicodeFromASCII(elementType, &uniElementType);
-        if(!OSstrcmp(uniElementType, _T("link")))
+        if(lookupViewKeyword(elementType, viewElementTypeKeywords, VIEW_KEYWORD_COUNT(viewElementTypeKeywords),
+                             VALUE_ELEMENT_TYPE) == VIEW_LINK_ELEMENT_TYPE)
         {
             //This is a link.. need to ignore, just reduce the menuGroup's count
             menuGroup->Count = menuGroup->Count - 1;
@@ -643,9 +780,18 @@ ERROR_STATUS FillMenuDataPoints(json_t * jsonElementArray, MenuGroup * menuGroup
             if(jsonTempObj != NULL)
             {
                 objReference = json_string_value(jsonTempObj);			
-                oid = GetOidFromFullQualifiedRefName(itemReference, objReference);
-
-                menuGroup->groupElements[temp].Data.ObjectOID = oid;
+                if(oidBatch != NULL)
+                {
+                    status = DeferViewOid(oidBatch, objReference, &menuGroup->groupElements[temp].Data.ObjectOID);
+                    if(status != OK)
+                        return status;
+                }
+                else
+                {
+                    oid = GetOidFromFullQualifiedRefName(itemReference, objReference);
+
+                    menuGroup->groupElements[temp].Data.ObjectOID = oid;
+                }
             }
             else
             {	
@@ -667,10 +813,6 @@ ERROR_STATUS FillMenuDataPoints(json_t * jsonElementArray, MenuGroup * menuGroup
 					menuGroup->groupElements[temp].Data.IgnorePresence = TRUE;
 			}
         }
-
-        //Release unicode string
-        OSrelease(uniElementType);
-
     }
 
     return OK;	
@@ -0,0 +1,475 @@
+/*------------------------------------------------------------------------------
+
+Module:   View Interface
+
+Purpose:  Evaluates the presence indicators of a view as a whole. The points the
+          group elements of a view depend on are collected once, each distinct
+          (ObjectOID, AttrRef) is read once per evaluation, in the data type its
+          operator compares in, and the operators are applied in one pass into a
+          visibility bitmap. The bitmap is evaluated again on every call, unless the
+          owner of the points reports their changes (EnableViewPresenceCache); then
+          it is kept until InvalidateViewPresence reports a change of one of them.
+
+Filename: view_presence.c
+
+Inputs:   viewId, group handle and element index of the view
+
+Outputs:  Presence of the group elements
+------------------------------------------------------------------------------*/
+#include <view_api.h>
+#include "view_api_private.h"
+#include "view_ext_private.h"
+
+#define VIEW_PRESENCE_WORD(bit)     ((bit) / VIEW_PRESENCE_WORD_BITS)
+#define VIEW_PRESENCE_MASK(bit)     ((UNSIGNED32)1 << ((bit) % VIEW_PRESENCE_WORD_BITS))
+
+/*------------------------------------------------------------------------------
+Module:   isPresenceOperator method
+
+Purpose:  Tells whether a group element carries a presence indicator the evaluator
+          knows how to apply.
+
+Inputs:   piOperator - PIOperator of the element
+
+Outputs:  TRUE if the operator is evaluated, FALSE otherwise
+------------------------------------------------------------------------------*/
+static UNSIGNED8 isPresenceOperator(UNSIGNED8 piOperator)
+{
+    switch(piOperator)
+    {
+        case PIOPERATOR_EQUAL:
+        case PIOPERATOR_NOTEQUAL:
+        case PIOPERATOR_GREATER:
+        case PIOPERATOR_LESSER:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+/*------------------------------------------------------------------------------
+Module:   presenceDataType method
+
+Purpose:  Returns the data type a presence indicator's point is read and compared
+          in, from its operator alone. EQUAL and NOTEQUAL are meant for enum, state
+          and unsigned points and compare the value read as unsigned against the
+          constant as is; GREATER and LESSER are meant for numeric points and compare
+          the value read as a real against the constant taken as signed.
+
+Inputs:   piOperator - PIOperator of the element
+
+Outputs:  VIEW_PRESENCE_ENUM_DATA_TYPE or VIEW_PRESENCE_REAL_DATA_TYPE
+------------------------------------------------------------------------------*/
+static UNSIGNED16 presenceDataType(UNSIGNED8 piOperator)
+{
+    if(piOperator == PIOPERATOR_EQUAL || piOperator == PIOPERATOR_NOTEQUAL)
+        return VIEW_PRESENCE_ENUM_DATA_TYPE;
+
+    return VIEW_PRESENCE_REAL_DATA_TYPE;
+}
+
+/*------------------------------------------------------------------------------
+Module:   buildViewPresence method
+
+Purpose:  Collects the presence indicators of a built view. Every distinct
+          (ObjectOID, AttrRef, data type) gets one entry in the read table, shared
+          by all the elements depending on it, found through a hash for the time
+          of the build. Everything else lives in one allocation.
+
+Inputs:   viewInfoExt - built view
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+static ERROR_STATUS buildViewPresence(VIEW_EQUIPMENT_INFO_EXT * viewInfoExt)
+{
+    VIEW_PRESENCE * presence;
+    VIEW_PRESENCE_POINT * point;
+    VIEW_PRESENCE_READ * read;
+    VIEW_PRESENCE_READ_KEY readKey;
+    PresenceIndicator * piPoint;
+    MenuGroup * menuGroup;
+    APSHASHTBL * readHash = NULL;
+    UNSIGNED32 numPoints = 0;
+    UNSIGNED32 numBits = 0;
+    UNSIGNED32 numWords;
+    UNSIGNED16 group;
+    UNSIGNED16 element;
+    ERROR_STATUS status = OK;
+
+    //Step - 1: Count the elements and the presence indicators of the view
+    for(group = 0; group < viewInfoExt->numGroups; group++)
+    {
+        menuGroup = (MenuGroup *)(viewInfoExt->groupBlock + viewInfoExt->groupOffsets[group]);
+        numBits += menuGroup->Count;
+
+        if(menuGroup->ElementType != GROUP_ELEMENT_TYPE)
+            continue;
+
+        for(element = 0; element < menuGroup->Count; element++)
+        {
+            if(isPresenceOperator(menuGroup->groupElements[element].Group.piPoint.PIOperator))
+                numPoints++;
+        }
+    }
+
+    numWords = (numBits + VIEW_PRESENCE_WORD_BITS - 1) / VIEW_PRESENCE_WORD_BITS;
+
+    //Step - 2: Read table, points, group bits and bitmap follow the structure
+    presence = (VIEW_PRESENCE *)OSacquire(sizeof(VIEW_PRESENCE) +
+                                          sizeof(VIEW_PRESENCE_READ) * numPoints +
+                                          sizeof(VIEW_PRESENCE_POINT) * numPoints +
+                                          sizeof(UNSIGNED32) * (viewInfoExt->numGroups + numWords));
+    if(presence == NULL)
+        return NOT_ENOUGH_MEMORY;
+
+    OSmemset(presence, 0, sizeof(VIEW_PRESENCE));
+    presence->reads = (VIEW_PRESENCE_READ *)(presence + 1);
+    presence->points = (VIEW_PRESENCE_POINT *)(presence->reads + numPoints);
+    presence->groupFirstBit = (UNSIGNED32 *)(presence->points + numPoints);
+    presence->bitmap = presence->groupFirstBit + viewInfoExt->numGroups;
+    presence->numBits = numBits;
+
+    //Hash list of the read table - (ObjectOID, AttrRef, data type) and its read entry
+    if(numPoints > 0)
+    {
+        readHash = hashtbl_create((hashSize)(numPoints < VIEW_PRESENCE_HASH_MAX_SIZE ? numPoints : VIEW_PRESENCE_HASH_MAX_SIZE), HASH_TYPE_STR);
+        if(readHash == NULL)
+        {
+            OSrelease(presence);
+            return HASH_CREATE_ERROR;
+        }
+    }
+
+    //Cleared once so padding compares equal
+    OSmemset(&readKey, 0, sizeof(readKey));
+
+    //Step - 3: Record the points in layout order, reading every distinct point once
+    numBits = 0;
+    for(group = 0; group < viewInfoExt->numGroups && status == OK; group++)
+    {
+        menuGroup = (MenuGroup *)(viewInfoExt->groupBlock + viewInfoExt->groupOffsets[group]);
+        presence->groupFirstBit[group] = numBits;
+
+        for(element = 0; menuGroup->ElementType == GROUP_ELEMENT_TYPE && element < menuGroup->Count; element++)
+        {
+            piPoint = &menuGroup->groupElements[element].Group.piPoint;
+            if(!isPresenceOperator(piPoint->PIOperator))
+                continue;
+
+            readKey.objectOid = piPoint->ObjectOID;
+            readKey.attrRef = piPoint->AttrRef;
+            readKey.dataType = presenceDataType(piPoint->PIOperator);
+
+            if(hashtbl_get(readHash, (hashKey *)&readKey, sizeof(readKey), (void **)&read))
+            {
+                read = &presence->reads[presence->numReads];
+                read->key = readKey;
+
+                status = hashtbl_insert(readHash, (hashKey *)&readKey, read, sizeof(readKey));
+                if(status != OK)
+                    break;
+
+                presence->numReads++;
+            }
+
+            point = &presence->points[presence->numPoints++];
+            point->bit = numBits + element;
+            point->readIndex = (UNSIGNED32)(read - presence->reads);
+            point->piConstant = piPoint->PIConstant;
+            point->piOperator = piPoint->PIOperator;
+        }
+
+        numBits += menuGroup->Count;
+    }
+
+    if(readHash != NULL)
+        hashtbl_destroy(readHash);
+
+    if(status != OK)
+    {
+        OSrelease(presence);
+        return status;
+    }
+
+    viewInfoExt->presence = presence;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   evaluateViewPresence method
+
+Purpose:  Reads every distinct point of the view once, then applies the operators
+          of all the presence indicators into the bitmap. An element whose point
+          cannot be read stays present.
+
+Inputs:   presence - presence evaluation of the view
+
+Outputs:  NA
+------------------------------------------------------------------------------*/
+static void evaluateViewPresence(VIEW_PRESENCE * presence)
+{
+    VIEW_PRESENCE_READ * read;
+    VIEW_PRESENCE_POINT * point;
+    VIEW_PRESENCE_REAL constant;
+    PARM_DATA parm;
+    UNSIGNED32 numWords = (presence->numBits + VIEW_PRESENCE_WORD_BITS - 1) / VIEW_PRESENCE_WORD_BITS;
+    UNSIGNED32 temp;
+    UNSIGNED8 present;
+
+    //Step - 1: Read the points, each in the data type it is compared in
+    for(temp = 0; temp < presence->numReads; temp++)
+    {
+        read = &presence->reads[temp];
+        read->readStatus = stdReadInternalAttr(read->key.objectOid, read->key.attrRef, &parm, read->key.dataType);
+        if(read->readStatus != OK)
+            continue;
+
+        if(read->key.dataType == VIEW_PRESENCE_ENUM_DATA_TYPE)
+            read->value = parm.parmValue.tUnsigned;
+        else
+            read->realValue = VIEW_PRESENCE_REAL_VALUE(parm);
+    }
+
+    //Step - 2: Every element present, then clear the ones whose indicator is false
+    OSmemset(presence->bitmap, 0xFF, sizeof(UNSIGNED32) * numWords);
+
+    for(temp = 0; temp < presence->numPoints; temp++)
+    {
+        point = &presence->points[temp];
+        read = &presence->reads[point->readIndex];
+
+        if(read->readStatus != OK)
+            continue;
+
+        constant = (VIEW_PRESENCE_REAL)(SIGNED32)point->piConstant;
+
+        switch(point->piOperator)
+        {
+            case PIOPERATOR_EQUAL:
+                present = (read->value == point->piConstant);
+                break;
+            case PIOPERATOR_NOTEQUAL:
+                present = (read->value != point->piConstant);
+                break;
+            case PIOPERATOR_GREATER:
+                present = (read->realValue > constant);
+                break;
+            default:
+                present = (read->realValue < constant);
+                break;
+        }
+
+        if(!present)
+            presence->bitmap[VIEW_PRESENCE_WORD(point->bit)] &= ~VIEW_PRESENCE_MASK(point->bit);
+    }
+
+    presence->valid = TRUE;
+}
+
+/*------------------------------------------------------------------------------
+Module:   getViewPresence method
+
+Purpose:  Returns the view and its up to date presence evaluation, building the
+          view and collecting its points on first use. The points are read again
+          unless the view is told of their changes and none was reported.
+
+Inputs:   viewId - view to evaluate
+
+Outputs:  viewInfoExt - the view
+          ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+static ERROR_STATUS getViewPresence(UNSIGNED16 viewId, VIEW_EQUIPMENT_INFO_EXT ** viewInfoExt)
+{
+    VIEW_DATABASE * viewDb;
+    VIEW_EQUIPMENT_INFO_EXT * viewInfo;
+    MODEL_CLASS_VARS *classVarPtr;
+    ERROR_STATUS status;
+
+    // get ptr to the model's class vars
+    classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+    viewDb = classVarPtr->view_database;
+    if(viewDb == NULL)
+        return VIEW_DATABASE_NOT_FOUND;
+
+    if(hashtbl_get(viewDb->viewHash, &viewId, sizeof(viewId), (void **)&viewInfo))
+        return JSONVIEW_NOT_FOUND;
+
+    //Build the view's MenuGroups on first use
+    status = MaterializeView(viewDb, viewInfo);
+    if(status != OK)
+        return status;
+
+    if(viewInfo->groupsByHandle == NULL)
+        return JSONVIEW_GROUPHASH_NOT_FOUND;
+
+    if(viewInfo->presence == NULL)
+    {
+        status = buildViewPresence(viewInfo);
+        if(status != OK)
+            return status;
+    }
+
+    if(!viewInfo->presence->notified || !viewInfo->presence->valid)
+        evaluateViewPresence(viewInfo->presence);
+
+    *viewInfoExt = viewInfo;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   GetViewPresence method
+
+Purpose:  Returns the visibility bitmap of a view, one bit per element of every
+          MenuGroup in layout order. The bitmap stays owned by the view and is
+          valid until the next presence call on the view.
+
+Inputs:   viewId - view to evaluate
+
+Outputs:  bitmap - Visibility bitmap, bit set when the element is present
+          numBits - Number of elements in the bitmap
+------------------------------------------------------------------------------*/
+ERROR_STATUS GetViewPresence(UNSIGNED16 viewId, const UNSIGNED32 ** bitmap, UNSIGNED32 * numBits)
+{
+    VIEW_EQUIPMENT_INFO_EXT * viewInfoExt;
+    ERROR_STATUS status;
+
+    status = getViewPresence(viewId, &viewInfoExt);
+    if(status != OK)
+        return status;
+
+    *bitmap = viewInfoExt->presence->bitmap;
+    *numBits = viewInfoExt->presence->numBits;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   IsGroupElementPresent method
+
+Purpose:  Returns whether an element of a group is present according to its
+          presence indicator, from the view's visibility bitmap. Every call
+          evaluates the view unless it is cached, a caller going over many elements
+          takes the bitmap from GetViewPresence once.
+
+Inputs:   viewId - view the group belongs to
+          groupHandle - handle of the group
+          elementIndex - index of the element in the group
+
+Outputs:  present - TRUE if the element is to be shown, FALSE otherwise
+------------------------------------------------------------------------------*/
+ERROR_STATUS IsGroupElementPresent(UNSIGNED16 viewId, UNSIGNED16 groupHandle, UNSIGNED16 elementIndex, UNSIGNED8 * present)
+{
+    VIEW_EQUIPMENT_INFO_EXT * viewInfoExt;
+    MenuGroup * menuGroup;
+    UNSIGNED32 offset;
+    UNSIGNED32 bit;
+    UNSIGNED16 low;
+    UNSIGNED16 high;
+    UNSIGNED16 mid;
+    ERROR_STATUS status;
+
+    status = getViewPresence(viewId, &viewInfoExt);
+    if(status != OK)
+        return status;
+
+    menuGroup = FindViewGroup(viewInfoExt, groupHandle);
+    if(menuGroup == NULL)
+        return JSONVIEW_MENUGROUP_NOT_FOUND;
+
+    if(elementIndex >= menuGroup->Count)
+        return ERROR_RESPONSE;
+
+    //The offsets grow in layout order, find the group's position from its offset
+    offset = (UNSIGNED32)((UNSIGNED8 *)menuGroup - viewInfoExt->groupBlock);
+    low = 0;
+    high = viewInfoExt->numGroups;
+    while(low < high)
+    {
+        mid = (UNSIGNED16)((low + high) / 2);
+        if(viewInfoExt->groupOffsets[mid] < offset)
+            low = (UNSIGNED16)(mid + 1);
+        else
+            high = mid;
+    }
+
+    if(low == viewInfoExt->numGroups || viewInfoExt->groupOffsets[low] != offset)
+        return JSONVIEW_MENUGROUP_NOT_FOUND;
+
+    bit = viewInfoExt->presence->groupFirstBit[low] + elementIndex;
+    *present = (viewInfoExt->presence->bitmap[VIEW_PRESENCE_WORD(bit)] & VIEW_PRESENCE_MASK(bit)) ? TRUE : FALSE;
+
+    return OK;
+}
+
+/*------------------------------------------------------------------------------
+Module:   EnableViewPresenceCache method
+
+Purpose:  This is a public accessible method, called by the owner of the points of a
+          view once it calls InvalidateViewPresence whenever one of them changes.
+          From then on the view's bitmap is kept across calls instead of the points
+          being read again on every presence call; without the notification a kept
+          bitmap could not be told apart from a changed point.
+
+Inputs:   viewId - view whose presence is to be kept
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+ERROR_STATUS EnableViewPresenceCache(UNSIGNED16 viewId)
+{
+    VIEW_EQUIPMENT_INFO_EXT * viewInfoExt;
+    ERROR_STATUS status;
+
+    status = getViewPresence(viewId, &viewInfoExt);
+    if(status == OK)
+        viewInfoExt->presence->notified = TRUE;
+
+    return status;
+}
+
+/*------------------------------------------------------------------------------
+Module:   InvalidateViewPresence method
+
+Purpose:  Reports a change of a point. Every cached view with a presence indicator on
+          the point is re-evaluated the next time its presence is asked for.
+
+Inputs:   objectOid - Internal OID of the object that changed
+          attrRef - Attribute that changed
+
+Outputs:  ERROR_STATUS returned if on any issue.
+------------------------------------------------------------------------------*/
+ERROR_STATUS InvalidateViewPresence(OID_TYPE objectOid, UNSIGNED16 attrRef)
+{
+    VIEW_DATABASE_EXT * viewDbExt;
+    VIEW_PRESENCE * presence;
+    MODEL_CLASS_VARS *classVarPtr;
+    UNSIGNED32 readIndex;
+    UNSIGNED16 temp;
+
+    // get ptr to the model's class vars
+    classVarPtr = cdbGetClassInstanceData(equipmentModelClassIndex);
+
+    viewDbExt = (VIEW_DATABASE_EXT *)classVarPtr->view_database;
+    if(viewDbExt == NULL)
+        return VIEW_DATABASE_NOT_FOUND;
+
+    for(temp = 0; temp < viewDbExt->numViews; temp++)
+    {
+        presence = viewDbExt->views[temp]->presence;
+        if(presence == NULL || !presence->valid)
+            continue;
+
+        for(readIndex = 0; readIndex < presence->numReads; readIndex++)
+        {
+            if(presence->reads[readIndex].key.objectOid == objectOid && presence->reads[readIndex].key.attrRef == attrRef)
+            {
+                presence->valid = FALSE;
+                break;
+            }
+        }
+    }
+
+    return OK;
+}